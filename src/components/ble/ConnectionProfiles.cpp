@@ -0,0 +1,148 @@
+#include "components/ble/ConnectionProfiles.h"
+#include <nrf_log.h>
+#include <task.h>
+
+#define min // workaround: nimble's min/max macros conflict with libstdc++
+#define max
+#include <nimble/nimble_port.h>
+#undef max
+#undef min
+
+using namespace Pinetime::Controllers;
+
+void ConnectionProfiles::Init() {
+  ble_npl_callout_init(&revertCallout, nimble_port_get_dflt_eventq(), RevertCallback, this);
+}
+
+void ConnectionProfiles::OnConnect(uint16_t handle) {
+  connectionHandle = handle;
+  current = Profiles::Idle;
+  profileStart = xTaskGetTickCount();
+  txPhy = 1;
+  rxPhy = 1;
+  OnConnectionUpdated(handle);
+  // A transfer may have been requested before the connection event was processed
+  if (clients != 0) {
+    Apply(Profiles::Bulk);
+  }
+}
+
+void ConnectionProfiles::OnDisconnect() {
+  ble_npl_callout_stop(&revertCallout);
+  UpdateDuration();
+  connectionHandle = BLE_HS_CONN_HANDLE_NONE;
+  current = Profiles::Idle;
+  LogStatistics();
+}
+
+void ConnectionProfiles::OnConnectionUpdated(uint16_t handle) {
+  ble_gap_conn_desc desc;
+  if (ble_gap_conn_find(handle, &desc) == 0) {
+    interval = desc.conn_itvl;
+    NRF_LOG_INFO("[ConnectionProfiles] interval %d x 1.25ms, latency %d, timeout %d x 10ms",
+                 desc.conn_itvl,
+                 desc.conn_latency,
+                 desc.supervision_timeout);
+  }
+}
+
+void ConnectionProfiles::OnPhyUpdated(uint8_t tx, uint8_t rx) {
+  txPhy = tx;
+  rxPhy = rx;
+  NRF_LOG_INFO("[ConnectionProfiles] PHY tx %dM, rx %dM", txPhy, rxPhy);
+}
+
+void ConnectionProfiles::Acquire(Clients client) {
+  clients |= static_cast<uint8_t>(client);
+  ble_npl_callout_stop(&revertCallout);
+  if (current != Profiles::Bulk) {
+    Apply(Profiles::Bulk);
+  }
+}
+
+void ConnectionProfiles::Release(Clients client) {
+  if ((clients.fetch_and(~static_cast<uint8_t>(client)) & ~static_cast<uint8_t>(client)) == 0) {
+    // The profile is applied by the BLE host task, when the callout expires
+    ble_npl_callout_reset(&revertCallout, ble_npl_time_ms_to_ticks32(revertDelay));
+  }
+}
+
+void ConnectionProfiles::AddBytes(uint32_t bytes) {
+  statistics[static_cast<uint8_t>(current)].bytes += bytes;
+}
+
+void ConnectionProfiles::Apply(Profiles profile) {
+  if (connectionHandle == BLE_HS_CONN_HANDLE_NONE) {
+    return;
+  }
+
+  UpdateDuration();
+  current = profile;
+  statistics[static_cast<uint8_t>(profile)].activations++;
+
+  const Parameters& parameters = (profile == Profiles::Bulk) ? bulkParameters : idleParameters;
+  ble_gap_upd_params params {};
+  params.itvl_min = parameters.intervalMin;
+  params.itvl_max = parameters.intervalMax;
+  params.latency = parameters.latency;
+  params.supervision_timeout = parameters.supervisionTimeout;
+  params.min_ce_len = 0;
+  params.max_ce_len = 0;
+  int rc = ble_gap_update_params(connectionHandle, &params);
+  if (rc != 0) {
+    NRF_LOG_WARNING("[ConnectionProfiles] Connection update failed: %d", rc);
+  }
+
+  // The controller keeps the current PHY if the peer does not support the preferred one
+  rc = ble_gap_set_prefered_le_phy(connectionHandle, parameters.phyMask, parameters.phyMask, 0);
+  if (rc != 0) {
+    NRF_LOG_WARNING("[ConnectionProfiles] PHY update failed: %d", rc);
+  }
+  NRF_LOG_INFO("[ConnectionProfiles] -> %s", ProfileToString(profile));
+}
+
+void ConnectionProfiles::UpdateDuration() {
+  const TickType_t now = xTaskGetTickCount();
+  if (connectionHandle != BLE_HS_CONN_HANDLE_NONE) {
+    statistics[static_cast<uint8_t>(current)].duration += now - profileStart;
+  }
+  profileStart = now;
+}
+
+void ConnectionProfiles::RevertCallback(ble_npl_event* event) {
+  auto* connectionProfiles = static_cast<ConnectionProfiles*>(ble_npl_event_get_arg(event));
+  if (connectionProfiles->clients == 0 && connectionProfiles->current != Profiles::Idle) {
+    connectionProfiles->Apply(Profiles::Idle);
+  }
+}
+
+uint32_t ConnectionProfiles::Throughput(Profiles profile) const {
+  const Statistics& stats = GetStatistics(profile);
+  if (stats.duration == 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(stats.bytes) * configTICK_RATE_HZ / stats.duration;
+}
+
+const char* ConnectionProfiles::ProfileToString(Profiles profile) {
+  switch (profile) {
+    case Profiles::Bulk:
+      return "Bulk";
+    default:
+      return "Idle";
+  }
+}
+
+void ConnectionProfiles::LogStatistics() const {
+  NRF_LOG_INFO("[ConnectionProfiles] Last PHY tx %dM, rx %dM, interval %d x 1.25ms", txPhy, rxPhy, interval);
+  for (size_t i = 0; i < nbProfiles; i++) {
+    const auto profile = static_cast<Profiles>(i);
+    const auto& stats = statistics[i];
+    NRF_LOG_INFO("[ConnectionProfiles] %s: %lu activations, %lu bytes in %lu ms, %lu B/s",
+                 ProfileToString(profile),
+                 stats.activations,
+                 stats.bytes,
+                 static_cast<uint32_t>(static_cast<uint64_t>(stats.duration) * 1000 / configTICK_RATE_HZ),
+                 Throughput(profile));
+  }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <FreeRTOS.h>
+
+#define min // workaround: nimble's min/max macros conflict with libstdc++
+#define max
+#include <host/ble_gap.h>
+#include <nimble/nimble_npl.h>
+#undef max
+#undef min
+
+namespace Pinetime {
+  namespace Controllers {
+    // Switches the connection between two sets of parameters: a low power profile used most of the time, and a bulk
+    // transfer profile (short connection interval, 2M PHY when the peer supports it) used while DFU or a file
+    // transfer is active. The data length extension (251 bytes PDUs) is negotiated by the controller when the
+    // connection is established, both profiles benefit from it.
+    // The connection goes back to the idle profile revertDelay after the last client released it, so that a
+    // sequence of small file transfers does not renegotiate the parameters for each of them.
+    class ConnectionProfiles {
+    public:
+      enum class Profiles : uint8_t { Idle, Bulk };
+      static constexpr size_t nbProfiles = 2;
+
+      enum class Clients : uint8_t { Dfu = 0x01, FileTransfer = 0x02 };
+
+      struct Statistics {
+        uint32_t activations = 0;
+        uint32_t bytes = 0;
+        TickType_t duration = 0;
+      };
+
+      void Init();
+      void OnConnect(uint16_t connectionHandle);
+      void OnDisconnect();
+      void OnConnectionUpdated(uint16_t connectionHandle);
+      void OnPhyUpdated(uint8_t txPhy, uint8_t rxPhy);
+
+      // Called from the BLE host task
+      void Acquire(Clients client);
+      // Can be called from any task
+      void Release(Clients client);
+      // Bytes transferred by the clients, counted in the current profile
+      void AddBytes(uint32_t bytes);
+
+      Profiles Current() const {
+        return current;
+      }
+
+      const Statistics& GetStatistics(Profiles profile) const {
+        return statistics[static_cast<uint8_t>(profile)];
+      }
+
+      // Average throughput of the transfers made in a profile, in bytes per second
+      uint32_t Throughput(Profiles profile) const;
+      static const char* ProfileToString(Profiles profile);
+      void LogStatistics() const;
+
+    private:
+      struct Parameters {
+        uint16_t intervalMin;        // 1.25ms units
+        uint16_t intervalMax;        // 1.25ms units
+        uint16_t latency;            // connection events
+        uint16_t supervisionTimeout; // 10ms units
+        uint8_t phyMask;
+      };
+
+      // 100-200ms with 4 skipped events when the watch has nothing to send
+      static constexpr Parameters idleParameters {80, 160, 4, 600, BLE_GAP_LE_PHY_1M_MASK};
+      // 15-30ms, the shortest interval accepted by most phones
+      static constexpr Parameters bulkParameters {12, 24, 0, 400, BLE_GAP_LE_PHY_2M_MASK};
+      static constexpr uint32_t revertDelay = 2000; // ms
+
+      void Apply(Profiles profile);
+      void UpdateDuration();
+      static void RevertCallback(ble_npl_event* event);
+
+      uint16_t connectionHandle = BLE_HS_CONN_HANDLE_NONE;
+      std::atomic<uint8_t> clients {0};
+      Profiles current = Profiles::Idle;
+      TickType_t profileStart = 0;
+      uint16_t interval = 0;
+      uint8_t txPhy = 1;
+      uint8_t rxPhy = 1;
+      std::array<Statistics, nbProfiles> statistics;
+      ble_npl_callout revertCallout;
+    };
+  }
+}
@@ -0,0 +1,254 @@
+#include "components/ble/DfuImage.h"
+#include <algorithm>
+#include <cstring>
+#include <task.h>
+#include <nrf_log.h>
+#include "nrf_assert.h"
+#include "drivers/SpiNorFlash.h"
+#include "utility/ElapsedTime.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  constexpr uint32_t magicNumber[4] = {
+    0xf395c277,
+    0x7fefd260,
+    0x0f505235,
+    0x8079b62c,
+  };
+}
+
+void DfuImage::Init(size_t chunkSize, size_t totalSize, uint16_t expectedCrc) {
+  if (chunkSize != 20)
+    return;
+  this->chunkSize = chunkSize;
+  this->totalSize = totalSize;
+  this->inputSize = totalSize;
+  this->expectedCrc = expectedCrc;
+  this->ready = true;
+  inputReceived = 0;
+  totalWriteIndex = 0;
+  bufferWriteIndex = 0;
+  crc = 0xFFFF;
+  magicWritten = false;
+  flashFailuresAtInit = FlashFailures();
+  compressed = false;
+  decompressionError = false;
+  window.reset();
+  startTime = xTaskGetTickCount();
+  maxStall = 0;
+  totalStall = 0;
+}
+
+void DfuImage::Reset() {
+  ready = false;
+  window.reset();
+}
+
+void DfuImage::Append(uint8_t* data, size_t size) {
+  if (!ready)
+    return;
+  ASSERT(size <= 20);
+  const Utility::ElapsedTime elapsed;
+
+  const bool first = (inputReceived == 0);
+  inputReceived += size;
+  if (first && size >= compressedHeaderSize && std::memcmp(data, compressedMagic, sizeof(compressedMagic)) == 0) {
+    StartDecompression(data);
+    data += compressedHeaderSize;
+    size -= compressedHeaderSize;
+  }
+
+  if (!compressed) {
+    Write(data, size);
+  } else if (!decompressionError) {
+    if (!decoder.Decode(data, size, OnDecompressed, this)) {
+      NRF_LOG_INFO("[DFU] Corrupted compressed image");
+      decompressionError = true;
+    }
+    if (decoder.IsDone() || decompressionError) {
+      window.reset();
+    }
+  }
+
+  const uint32_t stall = elapsed.Microseconds();
+  maxStall = std::max(maxStall, stall);
+  totalStall += stall;
+  if (IsComplete()) {
+    LogStatistics();
+  }
+}
+
+void DfuImage::StartDecompression(const uint8_t* header) {
+  const uint8_t version = header[4];
+  const uint8_t windowBits = header[5];
+  const uint32_t imageSize = header[8] | (header[9] << 8) | (header[10] << 16) | (static_cast<uint32_t>(header[11]) << 24);
+  compressed = true;
+  if (version != compressedVersion || windowBits < Utility::LzssDecoder::minWindowBits ||
+      windowBits > Utility::LzssDecoder::maxWindowBits || imageSize > maxSize) {
+    NRF_LOG_INFO("[DFU] Unsupported compressed image: version %d, window %d bits, size %lu", version, windowBits, imageSize);
+    decompressionError = true;
+    return;
+  }
+
+  // The window is only allocated during the transfer
+  totalSize = imageSize;
+  window = std::make_unique<uint8_t[]>(1 << windowBits);
+  decoder.Init(windowBits, imageSize, window.get());
+}
+
+void DfuImage::OnDecompressed(void* context, const uint8_t* data, size_t size) {
+  static_cast<DfuImage*>(context)->Write(data, size);
+}
+
+void DfuImage::Write(const uint8_t* data, size_t size) {
+  crc = ComputeCrc(data, size, &crc);
+
+  // The packets do not divide the page size, a packet can complete a page and start the next one
+  while (size > 0) {
+    const size_t length = std::min(size, bufferSize - bufferWriteIndex);
+    std::memcpy(tempBuffer + bufferWriteIndex, data, length);
+    bufferWriteIndex += length;
+    data += length;
+    size -= length;
+
+    if (bufferWriteIndex == bufferSize) {
+      WriteImage(totalWriteIndex, tempBuffer, bufferWriteIndex);
+      totalWriteIndex += bufferWriteIndex;
+      bufferWriteIndex = 0;
+    }
+  }
+
+  if (bufferWriteIndex > 0 && totalWriteIndex + bufferWriteIndex == totalSize) {
+    WriteImage(totalWriteIndex, tempBuffer, bufferWriteIndex);
+    totalWriteIndex += bufferWriteIndex;
+    bufferWriteIndex = 0;
+  }
+  // Data received after the end of the image must not program the magic number again
+  if (totalWriteIndex == totalSize && totalSize < maxSize && !magicWritten) {
+    WriteMagicNumber();
+  }
+}
+
+void DfuImage::WriteMagicNumber() {
+  // The SPI DMA cannot read the internal flash, where a constant is placed: the data to program must be in RAM
+  uint32_t magic[4];
+  std::memcpy(magic, magicNumber, sizeof(magic));
+
+  // The image does not reach the last sector, which has not been erased ahead
+  if (erasedSize < maxSize) {
+    spiNorFlash.SectorErase(writeOffset + maxSize - sectorSize);
+  }
+
+  uint32_t offset = writeOffset + (maxSize - sizeof(magic));
+  spiNorFlash.Write(offset, reinterpret_cast<const uint8_t*>(magic), sizeof(magic));
+  magicWritten = true;
+}
+
+bool DfuImage::MagicNumberWritten() {
+  uint32_t magic[4];
+  spiNorFlash.Read(writeOffset + (maxSize - sizeof(magic)), reinterpret_cast<uint8_t*>(magic), sizeof(magic));
+  return std::memcmp(magic, magicNumber, sizeof(magic)) == 0;
+}
+
+void DfuImage::LogStatistics() const {
+  const auto& statistics = spiNorFlash.GetWriteStatistics();
+  NRF_LOG_INFO("[DFU] Image received in %lu ms, stalled %lu ms (max %lu us)",
+               (xTaskGetTickCount() - startTime) * 1000 / configTICK_RATE_HZ,
+               totalStall / 1000,
+               maxStall);
+  if (compressed) {
+    NRF_LOG_INFO("[DFU] Compressed image: %lu bytes received for %lu bytes written",
+                 static_cast<uint32_t>(inputSize),
+                 static_cast<uint32_t>(totalWriteIndex));
+  }
+  NRF_LOG_INFO("[DFU] Flash: %lu bytes programmed, %lu sectors erased, callers blocked %lu ms",
+               statistics.bytesProgrammed,
+               statistics.sectorsErased,
+               statistics.blockedTime / 1000);
+}
+
+void DfuImage::Erase() {
+  // Only the first sector is erased now, the following ones are erased ahead of the data as it is received
+  erasedSize = 0;
+  spiNorFlash.BeginSectorErase(writeOffset);
+  erasedSize = sectorSize;
+}
+
+void DfuImage::WriteImage(size_t offset, const uint8_t* data, size_t size) {
+  const size_t end = offset + size;
+  // Normally the erase of these sectors was started long ago and is already done
+  while (erasedSize < end) {
+    spiNorFlash.SectorErase(writeOffset + erasedSize);
+    erasedSize += sectorSize;
+  }
+
+  spiNorFlash.Write(writeOffset + offset, data, size);
+
+  // Keep one sector erased ahead of the data, the erase runs while the next packets are received
+  if (erasedSize < end + sectorSize && erasedSize < maxSize) {
+    spiNorFlash.BeginSectorErase(writeOffset + erasedSize);
+    erasedSize += sectorSize;
+  }
+}
+
+bool DfuImage::Validate() {
+  // A compressed image is valid if it decompressed to the whole image with the expected CRC
+  if (!IsComplete() || decompressionError || (totalWriteIndex != totalSize) || (crc != expectedCrc)) {
+    return false;
+  }
+
+  // The image received is right, check that it was written: the read back waits for the last program, whose
+  // failure is then counted. The incremental CRC only covers the data received, not what the flash stored; the
+  // bootloader would swap in an image corrupted by a failed program, so it is read once (about 0.5 s for 400 KB).
+  const Utility::ElapsedTime readBackTime;
+  const uint16_t writtenCrc = ReadBackCrc();
+  NRF_LOG_INFO("[DFU] Image read back in %lu ms", readBackTime.Microseconds() / 1000);
+  const uint32_t flashFailures = FlashFailures() - flashFailuresAtInit;
+  const bool magicNumberValid = !magicWritten || MagicNumberWritten();
+  if (flashFailures > 0 || writtenCrc != expectedCrc || !magicNumberValid) {
+    NRF_LOG_INFO("[DFU] Image not written correctly: %lu flash failures, CRC read back 0x%04x, magic number %s",
+                 flashFailures,
+                 writtenCrc,
+                 magicNumberValid ? "valid" : "invalid");
+    return false;
+  }
+  return true;
+}
+
+uint16_t DfuImage::ReadBackCrc() {
+  uint16_t writtenCrc = 0xFFFF;
+  // The image is complete, the page buffer is free
+  spiNorFlash.ReadStream(writeOffset, totalSize, tempBuffer, bufferSize, OnReadBack, &writtenCrc);
+  return writtenCrc;
+}
+
+void DfuImage::OnReadBack(void* context, const uint8_t* data, size_t size) {
+  auto* writtenCrc = static_cast<uint16_t*>(context);
+  *writtenCrc = ComputeCrc(data, size, writtenCrc);
+}
+
+uint32_t DfuImage::FlashFailures() const {
+  const auto& statistics = spiNorFlash.GetWriteStatistics();
+  return statistics.programFailures + statistics.eraseFailures;
+}
+
+uint16_t DfuImage::ComputeCrc(uint8_t const* p_data, uint32_t size, uint16_t const* p_crc) {
+  uint16_t crc = (p_crc == NULL) ? 0xFFFF : *p_crc;
+
+  for (uint32_t i = 0; i < size; i++) {
+    crc = static_cast<uint8_t>(crc >> 8) | (crc << 8);
+    crc ^= p_data[i];
+    crc ^= static_cast<uint8_t>(crc & 0xFF) >> 4;
+    crc ^= (crc << 8) << 4;
+    crc ^= ((crc & 0xFF) << 4) << 1;
+  }
+
+  return crc;
+}
+
+bool DfuImage::IsComplete() {
+  if (!ready)
+    return false;
+  return inputReceived == inputSize;
+}
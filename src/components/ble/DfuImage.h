@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <FreeRTOS.h>
+#include "utility/LzssDecoder.h"
+
+namespace Pinetime {
+  namespace Drivers {
+    class SpiNorFlash;
+  }
+
+  namespace Controllers {
+    // Firmware image received by the DFU service, written to the OTA area of the external flash
+    class DfuImage {
+    public:
+      DfuImage(Pinetime::Drivers::SpiNorFlash& spiNorFlash) : spiNorFlash {spiNorFlash} {
+      }
+
+      void Init(size_t chunkSize, size_t totalSize, uint16_t expectedCrc);
+      void Erase();
+      void Append(uint8_t* data, size_t size);
+      // Checks the image received and the image written: the flash must have reported no program or erase failure,
+      // and the image read back from the flash must have the expected CRC and be followed by the magic number
+      bool Validate();
+      bool IsComplete();
+      // Frees the memory used to decompress the image
+      void Reset();
+
+      static uint16_t ComputeCrc(uint8_t const* p_data, uint32_t size, uint16_t const* p_crc);
+
+    private:
+      Pinetime::Drivers::SpiNorFlash& spiNorFlash;
+      // One flash page, the image is programmed with whole aligned pages
+      static constexpr size_t bufferSize = 256;
+      bool ready = false;
+      size_t chunkSize = 0;
+      // Size of the image, and of the data sent by the client, which is smaller when the image is compressed
+      size_t totalSize = 0;
+      size_t inputSize = 0;
+      size_t inputReceived = 0;
+      size_t maxSize = 475136;
+      static constexpr size_t sectorSize = 0x1000;
+      // Size of the beginning of the image area whose erase has been started
+      size_t erasedSize = 0;
+      size_t bufferWriteIndex = 0;
+      size_t totalWriteIndex = 0;
+      static constexpr size_t writeOffset = 0x40000;
+      uint8_t tempBuffer[bufferSize];
+      uint16_t expectedCrc = 0;
+      // CRC of the data received so far
+      uint16_t crc = 0xFFFF;
+      bool magicWritten = false;
+      // Program and erase failures reported by the flash before this image
+      uint32_t flashFailuresAtInit = 0;
+      TickType_t startTime = 0;
+      // Longest time spent in Append(), in us: BLE packets are not processed meanwhile
+      uint32_t maxStall = 0;
+      uint32_t totalStall = 0;
+
+      // Compressed images (see tools/dfu_compress.py) start with this header instead of the MCUBoot header
+      static constexpr size_t compressedHeaderSize = 12;
+      static constexpr uint8_t compressedMagic[4] = {'I', 'T', 'L', 'Z'};
+      static constexpr uint8_t compressedVersion = 1;
+      bool compressed = false;
+      bool decompressionError = false;
+      Pinetime::Utility::LzssDecoder decoder;
+      std::unique_ptr<uint8_t[]> window;
+
+      void StartDecompression(const uint8_t* header);
+      void Write(const uint8_t* data, size_t size);
+      static void OnDecompressed(void* context, const uint8_t* data, size_t size);
+      void WriteMagicNumber();
+      bool MagicNumberWritten();
+      // Reads the image through tempBuffer, in 254 + 2 bytes SPI bursts (see SpiMaster::BurstSize())
+      uint16_t ReadBackCrc();
+      static void OnReadBack(void* context, const uint8_t* data, size_t size);
+      uint32_t FlashFailures() const;
+      void WriteImage(size_t offset, const uint8_t* data, size_t size);
+      void LogStatistics() const;
+    };
+  }
+}
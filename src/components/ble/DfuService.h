@@ -8,6 +8,7 @@
 #include <host/ble_gap.h>
 #undef max
 #undef min
+#include "components/ble/DfuImage.h"
 
 namespace Pinetime {
   namespace System {
@@ -20,12 +21,14 @@ namespace Pinetime {
 
   namespace Controllers {
     class Ble;
+    class ConnectionProfiles;
 
     class DfuService {
     public:
       DfuService(Pinetime::System::SystemTask& systemTask,
                  Pinetime::Controllers::Ble& bleController,
-                 Pinetime::Drivers::SpiNorFlash& spiNorFlash);
+                 Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                 Pinetime::Controllers::ConnectionProfiles& connectionProfiles);
       void Init();
       int OnServiceData(uint16_t connectionHandle, uint16_t attributeHandle, ble_gatt_access_ctxt* context);
       void OnTimeout();
@@ -49,34 +52,6 @@ namespace Pinetime {
         void Reset();
       };
 
-      class DfuImage {
-      public:
-        DfuImage(Pinetime::Drivers::SpiNorFlash& spiNorFlash) : spiNorFlash {spiNorFlash} {
-        }
-
-        void Init(size_t chunkSize, size_t totalSize, uint16_t expectedCrc);
-        void Erase();
-        void Append(uint8_t* data, size_t size);
-        bool Validate();
-        bool IsComplete();
-
-      private:
-        Pinetime::Drivers::SpiNorFlash& spiNorFlash;
-        static constexpr size_t bufferSize = 200;
-        bool ready = false;
-        size_t chunkSize = 0;
-        size_t totalSize = 0;
-        size_t maxSize = 475136;
-        size_t bufferWriteIndex = 0;
-        size_t totalWriteIndex = 0;
-        static constexpr size_t writeOffset = 0x40000;
-        uint8_t tempBuffer[bufferSize];
-        uint16_t expectedCrc = 0;
-
-        void WriteMagicNumber();
-        uint16_t ComputeCrc(uint8_t const* p_data, uint32_t size, uint16_t const* p_crc);
-      };
-
       static constexpr ble_uuid128_t serviceUuid {
         .u {.type = BLE_UUID_TYPE_128},
         .value = {0x23, 0xD1, 0xBC, 0xEA, 0x5F, 0x78, 0x23, 0x15, 0xDE, 0xEF, 0x12, 0x12, 0x30, 0x15, 0x00, 0x00}};
@@ -84,6 +59,7 @@ namespace Pinetime {
     private:
       Pinetime::System::SystemTask& systemTask;
       Pinetime::Controllers::Ble& bleController;
+      Pinetime::Controllers::ConnectionProfiles& connectionProfiles;
       DfuImage dfuImage;
       NotificationManager notificationManager;
 
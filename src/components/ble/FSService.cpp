@@ -1,6 +1,7 @@
 #include <nrf_log.h>
 #include "FSService.h"
 #include "components/ble/BleController.h"
+#include "components/ble/ConnectionProfiles.h"
 #include "systemtask/SystemTask.h"
 
 using namespace Pinetime::Controllers;
@@ -14,9 +15,12 @@ int FSServiceCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gat
   return fsService->OnFSServiceRequested(conn_handle, attr_handle, ctxt);
 }
 
-FSService::FSService(Pinetime::System::SystemTask& systemTask, Pinetime::Controllers::FS& fs)
+FSService::FSService(Pinetime::System::SystemTask& systemTask,
+                     Pinetime::Controllers::FS& fs,
+                     Pinetime::Controllers::ConnectionProfiles& connectionProfiles)
   : systemTask {systemTask},
     fs {fs},
+    connectionProfiles {connectionProfiles},
     characteristicDefinition {{.uuid = &fsVersionUuid.u,
                                .access_cb = FSServiceCallback,
                                .arg = this,
@@ -26,7 +30,7 @@ FSService::FSService(Pinetime::System::SystemTask& systemTask, Pinetime::Control
                                 .uuid = &fsTransferUuid.u,
                                 .access_cb = FSServiceCallback,
                                 .arg = this,
-                                .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
+                                .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP | BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
                                 .val_handle = &transferCharacteristicHandle,
                               },
                               {0}},
@@ -46,6 +50,15 @@ void FSService::Init() {
 
   res = ble_gatts_add_svcs(serviceDefinition);
   ASSERT(res == 0);
+
+  ble_npl_callout_init(&streamCallout, nimble_port_get_dflt_eventq(), StreamCallback, this);
+}
+
+void FSService::OnDisconnect() {
+  streaming = false;
+  ble_npl_callout_stop(&streamCallout);
+  CloseReadFile();
+  AbortUpload();
 }
 
 int FSService::OnFSServiceRequested(uint16_t connectionHandle, uint16_t attributeHandle, ble_gatt_access_ctxt* context) {
@@ -63,6 +76,36 @@ int FSService::OnFSServiceRequested(uint16_t connectionHandle, uint16_t attribut
 int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
   auto command = static_cast<commands>(om->om_data[0]);
   NRF_LOG_INFO("[FS_S] -> FSCommandHandler Command %d", command);
+
+  // Commands that continue a read are answered right away, the watch was woken up when the read started
+  if (command == commands::READ_CREDIT) {
+    auto* header = (ReadCredit*) om->om_data;
+    if (streaming) {
+      streamCreditEnd = std::max(streamCreditEnd, header->received + header->window);
+      Stream();
+    }
+    return 0;
+  }
+  if (command == commands::WRITE_DATA && uploading) {
+    ReceiveUploadData((WritePacing*) om->om_data);
+    return 0;
+  }
+  if (command == commands::READ_PACING && readFileOpen) {
+    auto* header = (ReadPacing*) om->om_data;
+    const int res = ReadChunk(header->chunkoff, std::min<uint32_t>(header->chunksize, ChunkSize(connectionHandle)));
+    SendReadData(connectionHandle, (res < 0) ? res : 0x01, header->chunkoff, std::max(res, 0));
+    if (readFilePosition >= readFileSize) {
+      CloseReadFile();
+    }
+    return 0;
+  }
+  if (command != commands::READ_PACING) {
+    streaming = false;
+    CloseReadFile();
+  }
+
+  connectionProfiles.Acquire(ConnectionProfiles::Clients::FileTransfer);
+
   // Just always make sure we are awake...
   systemTask.PushMessage(Pinetime::System::Messages::StartFileTransfer);
   vTaskDelay(10);
@@ -73,71 +116,48 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
   lfs_info info = {0};
   lfs_file f = {0};
   switch (command) {
-    case commands::READ: {
+    case commands::READ:
+    case commands::READ_STREAM: {
       NRF_LOG_INFO("[FS_S] -> Read");
       auto* header = (ReadHeader*) om->om_data;
       uint16_t plen = header->pathlen;
-      if (plen > maxpathlen) { //> counts for null term
+      if (plen >= maxpathlen) { // counts for null term
         return -1;
       }
       memcpy(filepath, header->pathstr, plen);
       filepath[plen] = 0; // Copy and null terminate string
-      ReadResponse resp;
-      os_mbuf* om;
-      resp.command = commands::READ_DATA;
-      resp.status = 0x01;
-      resp.chunkoff = header->chunkoff;
-      int res = fs.Stat(filepath, &info);
-      if (res == LFS_ERR_NOENT && info.type != LFS_TYPE_DIR) {
-        resp.status = (int8_t) res;
-        resp.chunklen = 0;
-        resp.totallen = 0;
-        om = ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse));
-      } else {
-        resp.chunklen = std::min(header->chunksize, info.size); // TODO add mtu somehow
-        resp.totallen = info.size;
-        fs.FileOpen(&f, filepath, LFS_O_RDONLY);
-        fs.FileSeek(&f, header->chunkoff);
-        uint8_t fileData[resp.chunklen] = {0};
-        resp.chunklen = fs.FileRead(&f, fileData, resp.chunklen);
-        om = ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse));
-        os_mbuf_append(om, fileData, resp.chunklen);
-        fs.FileClose(&f);
+      int res = OpenReadFile();
+      if (res < 0) {
+        SendReadData(connectionHandle, res, header->chunkoff, 0);
+        break;
+      }
+      if (command == commands::READ_STREAM) {
+        streaming = true;
+        streamConnectionHandle = connectionHandle;
+        streamOffset = header->chunkoff;
+        streamCreditEnd = header->chunkoff + header->chunksize;
+        Stream();
+        break;
+      }
+      res = ReadChunk(header->chunkoff, std::min<uint32_t>(header->chunksize, ChunkSize(connectionHandle)));
+      SendReadData(connectionHandle, (res < 0) ? res : 0x01, header->chunkoff, std::max(res, 0));
+      if (readFilePosition >= readFileSize) {
+        CloseReadFile();
       }
-
-      ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
       break;
     }
     case commands::READ_PACING: {
+      // The file was closed at its end, or by another command
       NRF_LOG_INFO("[FS_S] -> Readpacing");
-      auto* header = (ReadHeader*) om->om_data;
-      ReadResponse resp;
-      resp.command = commands::READ_DATA;
-      resp.status = 0x01;
-      resp.chunkoff = header->chunkoff;
-      int res = fs.Stat(filepath, &info);
-      if (res == LFS_ERR_NOENT && info.type != LFS_TYPE_DIR) {
-        resp.status = (int8_t) res;
-        resp.chunklen = 0;
-        resp.totallen = 0;
-      } else {
-        resp.chunklen = std::min(header->chunksize, info.size); // TODO add mtu somehow
-        resp.totallen = info.size;
-        fs.FileOpen(&f, filepath, LFS_O_RDONLY);
-        fs.FileSeek(&f, header->chunkoff);
+      auto* header = (ReadPacing*) om->om_data;
+      int res = OpenReadFile();
+      if (res >= 0) {
+        res = ReadChunk(header->chunkoff, std::min<uint32_t>(header->chunksize, ChunkSize(connectionHandle)));
       }
-      os_mbuf* om;
-      if (resp.chunklen > 0) {
-        uint8_t fileData[resp.chunklen] = {0};
-        resp.chunklen = fs.FileRead(&f, fileData, resp.chunklen);
-        om = ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse));
-        os_mbuf_append(om, fileData, resp.chunklen);
-      } else {
-        resp.chunklen = 0;
-        om = ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse));
+      SendReadData(connectionHandle, (res < 0) ? res : 0x01, header->chunkoff, std::max(res, 0));
+      if (readFilePosition >= readFileSize) {
+        CloseReadFile();
       }
-      fs.FileClose(&f);
-      ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
       break;
     }
     case commands::WRITE: {
@@ -165,6 +185,16 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
       break;
     }
+    case commands::WRITE_STREAM: {
+      NRF_LOG_INFO("[FS_S] -> WriteStream");
+      auto* header = (WriteHeader*) om->om_data;
+      uint16_t plen = header->pathlen;
+      if (plen >= maxpathlen) { // counts for null term
+        return -1;
+      }
+      StartUpload(connectionHandle, header);
+      break;
+    }
     case commands::WRITE_DATA: {
       NRF_LOG_INFO("[FS_S] -> WriteData");
       auto* header = (WritePacing*) om->om_data;
@@ -177,11 +207,15 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
         if ((res = fs.FileSeek(&f, header->offset)) >= 0) {
           res = fs.FileWrite(&f, header->data, header->dataSize);
         }
+        connectionProfiles.AddBytes(header->dataSize);
         fs.FileClose(&f);
       }
       if (res < 0) {
         resp.status = (int8_t) res;
       }
+      if (res < 0 || header->offset + header->dataSize >= fileSize) {
+        NotifyFilesChanged();
+      }
       resp.freespace = std::min(fs.getSize() - (fs.GetFSSize() * fs.getBlockSize()), fileSize - header->offset);
       auto* om = ble_hs_mbuf_from_flat(&resp, sizeof(WriteResponse));
       ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
@@ -198,6 +232,9 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       resp.command = commands::DELETE_STATUS;
       int res = fs.FileDelete(path);
       resp.status = (res == 0) ? 0x01 : (int8_t) res;
+      if (res == 0) {
+        NotifyFilesChanged();
+      }
       auto* om = ble_hs_mbuf_from_flat(&resp, sizeof(DelResponse));
       ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
       break;
@@ -295,6 +332,9 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       resp.command = commands::MOVE_STATUS;
       int8_t res = (int8_t) fs.Rename(header->pathstr, path);
       resp.status = (res == 0) ? 1 : res;
+      if (res == 0) {
+        NotifyFilesChanged();
+      }
       auto* om = ble_hs_mbuf_from_flat(&resp, sizeof(MoveResponse));
       ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
     }
@@ -302,29 +342,261 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       break;
   }
   NRF_LOG_INFO("[FS_S] -> done ");
+  UpdateConnectionProfile();
   systemTask.PushMessage(Pinetime::System::Messages::StopFileTransfer);
   return 0;
 }
 
-// Loads resp with file data given a valid filepath header and resp
-void FSService::prepareReadDataResp(ReadHeader* header, ReadResponse* resp) {
-  // uint16_t plen = header->pathlen;
-  resp->command = commands::READ_DATA;
-  resp->chunkoff = header->chunkoff;
-  resp->status = 0x01;
-  struct lfs_info info = {};
-  int res = fs.Stat(filepath, &info);
-  if (res == LFS_ERR_NOENT && info.type != LFS_TYPE_DIR) {
-    resp->status = 0x03;
-    resp->chunklen = 0;
-    resp->totallen = 0;
-  } else {
-    lfs_file f;
-    resp->chunklen = std::min(header->chunksize, info.size);
-    resp->totallen = info.size;
-    fs.FileOpen(&f, filepath, LFS_O_RDONLY);
-    fs.FileSeek(&f, header->chunkoff);
-    resp->chunklen = fs.FileRead(&f, resp->chunk, resp->chunklen);
-    fs.FileClose(&f);
+void FSService::StartUpload(uint16_t connectionHandle, WriteHeader* header) {
+  if (uploading) {
+    // The previous upload is closed by SystemTask, the client can try again once it is done
+    AbortUpload();
+    SendWritePacing(connectionHandle, LFS_ERR_INVAL, header->offset, 0, 0);
+    return;
+  }
+
+  memcpy(filepath, header->pathstr, header->pathlen);
+  filepath[header->pathlen] = 0; // Copy and null terminate string
+  const int flags = LFS_O_WRONLY | LFS_O_CREAT | ((header->offset == 0) ? LFS_O_TRUNC : 0);
+  int res = fs.FileOpen(&uploadFile, filepath, flags);
+  if (res >= 0) {
+    res = fs.FileSeek(&uploadFile, header->offset);
+    if (res < 0) {
+      fs.FileClose(&uploadFile);
+    }
+  }
+  if (res < 0) {
+    SendWritePacing(connectionHandle, res, header->offset, 0, 0);
+    return;
+  }
+
+  uploadConnectionHandle = connectionHandle;
+  uploadSize = header->totalSize;
+  uploadReceived = header->offset;
+  uploadWritten = header->offset;
+  uploadAborted = false;
+  uploading = true;
+  // Keeps the watch awake until the upload is done
+  systemTask.PushMessage(Pinetime::System::Messages::StartFileTransfer);
+  SendWritePacing(connectionHandle, 0x01, header->offset, uploadSize - header->offset, uploadWindow);
+  if (header->offset >= uploadSize) {
+    // Nothing to receive, the file is closed right away
+    RequestUploadDrain();
+  }
+}
+
+void FSService::ReceiveUploadData(WritePacing* header) {
+  const uint32_t received = uploadReceived;
+  if (uploadAborted) {
+    return;
+  }
+  // Data is expected in order and within the window
+  if (header->offset != received || (received - uploadWritten) + header->dataSize > uploadWindow ||
+      received + header->dataSize > uploadSize) {
+    NRF_LOG_WARNING("[FS_S] Upload: unexpected data at %lu", header->offset);
+    SendWritePacing(uploadConnectionHandle, LFS_ERR_INVAL, uploadWritten, 0, 0);
+    AbortUpload();
+    return;
+  }
+
+  const uint32_t index = received % uploadWindow;
+  const uint32_t firstPart = std::min<uint32_t>(header->dataSize, uploadWindow - index);
+  memcpy(&uploadBuffer[index], header->data, firstPart);
+  memcpy(uploadBuffer.data(), header->data + firstPart, header->dataSize - firstPart);
+  uploadReceived = received + header->dataSize;
+  connectionProfiles.AddBytes(header->dataSize);
+
+  if (uploadReceived - uploadWritten >= uploadBatchSize || uploadReceived == uploadSize) {
+    RequestUploadDrain();
+  }
+}
+
+void FSService::AbortUpload() {
+  if (uploading) {
+    uploadAborted = true;
+    RequestUploadDrain();
+  }
+}
+
+void FSService::RequestUploadDrain() {
+  if (!uploadDrainRequested.exchange(true)) {
+    systemTask.PushMessage(Pinetime::System::Messages::FileTransferData);
+  }
+}
+
+void FSService::ProcessUpload() {
+  uploadDrainRequested = false;
+  if (!uploading) {
+    return;
+  }
+  if (uploadAborted) {
+    fs.FileClose(&uploadFile);
+    uploading = false;
+    UpdateConnectionProfile();
+    NotifyFilesChanged();
+    systemTask.PushMessage(Pinetime::System::Messages::StopFileTransfer);
+    return;
+  }
+
+  // Whole batches are written, aligned on their offset in the file, and the rest once all the data is received
+  const uint32_t received = uploadReceived;
+  uint32_t written = uploadWritten;
+  const uint32_t end = (received >= uploadSize) ? received : received - (received % uploadBatchSize);
+  while (written < end) {
+    const uint32_t index = written % uploadWindow;
+    const uint32_t length = std::min<uint32_t>(end - written, uploadWindow - index);
+    const int res = fs.FileWrite(&uploadFile, &uploadBuffer[index], length);
+    if (res < 0) {
+      SendWritePacing(uploadConnectionHandle, res, written, 0, 0);
+      uploadAborted = true;
+      ProcessUpload();
+      return;
+    }
+    written += length;
+    uploadWritten = written;
+  }
+
+  if (written >= uploadSize) {
+    written = uploadSize;
+    fs.FileClose(&uploadFile);
+    uploading = false;
+    UpdateConnectionProfile();
+    NotifyFilesChanged();
+    systemTask.PushMessage(Pinetime::System::Messages::StopFileTransfer);
+  }
+  // Cumulative acknowledgement, it also opens the window for more data
+  SendWritePacing(uploadConnectionHandle, 0x01, written, uploadSize - written, uploadWindow);
+}
+
+int FSService::SendWritePacing(uint16_t connectionHandle, int8_t status, uint32_t offset, uint32_t freespace, uint16_t window) {
+  WriteResponse resp;
+  resp.command = commands::WRITE_PACING;
+  resp.status = status;
+  resp.padding = window;
+  resp.offset = offset;
+  resp.modTime = 0;
+  resp.freespace = freespace;
+  auto* om = ble_hs_mbuf_from_flat(&resp, sizeof(WriteResponse));
+  return ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
+}
+
+int FSService::OpenReadFile() {
+  CloseReadFile();
+  readFilePosition = 0;
+  readFileSize = 0;
+  int res = fs.FileOpen(&readFile, filepath, LFS_O_RDONLY);
+  if (res < 0) {
+    return res;
+  }
+  res = fs.FileSize(&readFile);
+  if (res < 0) {
+    fs.FileClose(&readFile);
+    return res;
+  }
+  readFileOpen = true;
+  readFileSize = res;
+  // Keeps the watch awake until the file is closed, the READ_PACING and READ_CREDIT commands read it without waking it up
+  systemTask.PushMessage(Pinetime::System::Messages::StartFileTransfer);
+  return 0;
+}
+
+void FSService::CloseReadFile() {
+  if (readFileOpen) {
+    fs.FileClose(&readFile);
+    readFileOpen = false;
+    UpdateConnectionProfile();
+    systemTask.PushMessage(Pinetime::System::Messages::StopFileTransfer);
   }
 }
+
+void FSService::UpdateConnectionProfile() {
+  if (!readFileOpen && !uploading) {
+    connectionProfiles.Release(ConnectionProfiles::Clients::FileTransfer);
+  }
+}
+
+void FSService::NotifyFilesChanged() {
+  systemTask.PushMessage(Pinetime::System::Messages::OnFilesChanged);
+}
+
+int FSService::ReadChunk(uint32_t offset, uint32_t size) {
+  if (!readFileOpen) {
+    return LFS_ERR_BADF;
+  }
+  if (offset != readFilePosition) {
+    int res = fs.FileSeek(&readFile, offset);
+    if (res < 0) {
+      return res;
+    }
+    readFilePosition = offset;
+  }
+  int res = fs.FileRead(&readFile, readBuffer.data(), std::min<uint32_t>(size, readBuffer.size()));
+  if (res > 0) {
+    readFilePosition += res;
+  }
+  return res;
+}
+
+uint16_t FSService::ChunkSize(uint16_t connectionHandle) const {
+  const uint16_t mtu = ble_att_mtu(connectionHandle);
+  // ATT notification header (3 bytes) and READ_DATA header
+  if (mtu <= 3 + sizeof(ReadResponse)) {
+    return 1;
+  }
+  return std::min<uint16_t>(mtu - 3 - sizeof(ReadResponse), maxChunkSize);
+}
+
+int FSService::SendReadData(uint16_t connectionHandle, int8_t status, uint32_t offset, uint32_t length) {
+  ReadResponse resp;
+  resp.command = commands::READ_DATA;
+  resp.status = status;
+  resp.padding = 0;
+  resp.chunkoff = offset;
+  resp.totallen = readFileSize;
+  resp.chunklen = length;
+  os_mbuf* om = ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse));
+  if (om == nullptr) {
+    return BLE_HS_ENOMEM;
+  }
+  if (length > 0 && os_mbuf_append(om, readBuffer.data(), length) != 0) {
+    os_mbuf_free_chain(om);
+    return BLE_HS_ENOMEM;
+  }
+  connectionProfiles.AddBytes(length);
+  return ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
+}
+
+void FSService::Stream() {
+  const uint16_t chunkSize = ChunkSize(streamConnectionHandle);
+  while (streaming && streamOffset < streamCreditEnd) {
+    if (os_msys_num_free() < streamMinFreeMbufs) {
+      ble_npl_callout_reset(&streamCallout, ble_npl_time_ms_to_ticks32(streamRetryDelay));
+      return;
+    }
+
+    const uint32_t remaining = (streamOffset < readFileSize) ? readFileSize - streamOffset : 0;
+    const uint32_t length = std::min<uint32_t>({chunkSize, streamCreditEnd - streamOffset, remaining});
+    const int res = ReadChunk(streamOffset, length);
+    if (res < 0) {
+      SendReadData(streamConnectionHandle, res, streamOffset, 0);
+      streaming = false;
+      CloseReadFile();
+      return;
+    }
+    if (SendReadData(streamConnectionHandle, 0x01, streamOffset, res) != 0) {
+      // The chunk is read again when the stream resumes
+      ble_npl_callout_reset(&streamCallout, ble_npl_time_ms_to_ticks32(streamRetryDelay));
+      return;
+    }
+    streamOffset += res;
+    if (streamOffset >= readFileSize) {
+      streaming = false;
+      CloseReadFile();
+    }
+  }
+}
+
+void FSService::StreamCallback(ble_npl_event* event) {
+  auto* fsService = static_cast<FSService*>(ble_npl_event_get_arg(event));
+  fsService->Stream();
+}
@@ -2,9 +2,14 @@
 #define min // workaround: nimble's min/max macros conflict with libstdc++
 #define max
 #include <host/ble_gap.h>
+#include <host/ble_att.h>
+#include <nimble/nimble_npl.h>
+#include <nimble/nimble_port.h>
 #undef max
 #undef min
 
+#include <array>
+#include <atomic>
 #include "components/fs/FS.h"
 
 namespace Pinetime {
@@ -14,18 +19,25 @@ namespace Pinetime {
 
   namespace Controllers {
     class Ble;
+    class ConnectionProfiles;
 
     class FSService {
     public:
-      FSService(Pinetime::System::SystemTask& systemTask, Pinetime::Controllers::FS& fs);
+      FSService(Pinetime::System::SystemTask& systemTask,
+                Pinetime::Controllers::FS& fs,
+                Pinetime::Controllers::ConnectionProfiles& connectionProfiles);
       void Init();
 
       int OnFSServiceRequested(uint16_t connectionHandle, uint16_t attributeHandle, ble_gatt_access_ctxt* context);
       void NotifyFSRaw(uint16_t connectionHandle);
+      void OnDisconnect();
+      // Writes the data of a streaming upload to the file, called by SystemTask
+      void ProcessUpload();
 
     private:
       Pinetime::System::SystemTask& systemTask;
       Pinetime::Controllers::FS& fs;
+      Pinetime::Controllers::ConnectionProfiles& connectionProfiles;
       static constexpr uint16_t FSServiceId {0xFEBB};
       static constexpr uint16_t fsVersionId {0x0100};
       static constexpr uint16_t fsTransferId {0x0200};
@@ -53,9 +65,12 @@ namespace Pinetime {
         READ = 0x10,
         READ_DATA = 0x11,
         READ_PACING = 0x12,
+        READ_STREAM = 0x13,
+        READ_CREDIT = 0x14,
         WRITE = 0x20,
         WRITE_PACING = 0x21,
         WRITE_DATA = 0x22,
+        WRITE_STREAM = 0x23,
         DELETE = 0x30,
         DELETE_STATUS = 0x31,
         MKDIR = 0x40,
@@ -190,8 +205,66 @@ namespace Pinetime {
         uint8_t status;
       };
 
+      using ReadCredit = struct __attribute__((packed)) {
+        commands command;
+        uint8_t padding;
+        uint16_t padding2;
+        uint32_t received;
+        uint32_t window;
+      };
+
+      // A read keeps its file open until the end of the file or until another file is read.
+      // Chunks are read into a buffer sized for the largest ATT MTU, not on the stack of the BLE host.
+      static constexpr size_t maxChunkSize = MYNEWT_VAL_BLE_ATT_PREFERRED_MTU - 3 - sizeof(ReadResponse);
+      std::array<uint8_t, maxChunkSize> readBuffer;
+      lfs_file_t readFile;
+      bool readFileOpen = false;
+      uint32_t readFilePosition = 0;
+      uint32_t readFileSize = 0;
+
+      // Streaming reads send chunks without waiting for READ_PACING, as long as the client granted credit for them
+      bool streaming = false;
+      uint16_t streamConnectionHandle = 0;
+      uint32_t streamOffset = 0;
+      uint32_t streamCreditEnd = 0;
+      // Mbufs left for the other services while streaming, the stream resumes later when they run short
+      static constexpr int streamMinFreeMbufs = 4;
+      static constexpr uint32_t streamRetryDelay = 5; // ms
+      ble_npl_callout streamCallout;
+
+      // Streaming uploads: data written without response is queued in a ring buffer by the BLE host and written to the
+      // file by SystemTask in page-aligned batches. The client may send up to uploadWindow bytes beyond the offset
+      // acknowledged by the last WRITE_PACING.
+      static constexpr size_t uploadWindow = 2048;
+      static constexpr size_t uploadBatchSize = 256;
+      std::array<uint8_t, uploadWindow> uploadBuffer;
+      lfs_file_t uploadFile;
+      std::atomic<bool> uploading {false};
+      std::atomic<bool> uploadAborted {false};
+      std::atomic<bool> uploadDrainRequested {false};
+      // Offsets in the file: received by the BLE host, written by SystemTask
+      std::atomic<uint32_t> uploadReceived {0};
+      std::atomic<uint32_t> uploadWritten {0};
+      uint32_t uploadSize = 0;
+      uint16_t uploadConnectionHandle = 0;
+
       int FSCommandHandler(uint16_t connectionHandle, os_mbuf* om);
-      void prepareReadDataResp(ReadHeader* header, ReadResponse* resp);
+      void StartUpload(uint16_t connectionHandle, WriteHeader* header);
+      void ReceiveUploadData(WritePacing* header);
+      void AbortUpload();
+      void RequestUploadDrain();
+      int SendWritePacing(uint16_t connectionHandle, int8_t status, uint32_t offset, uint32_t freespace, uint16_t window);
+      // Lets the connection go back to the idle profile when no transfer is active
+      void UpdateConnectionProfile();
+      // The display drops the fonts it cached, their files may have been replaced
+      void NotifyFilesChanged();
+      int OpenReadFile();
+      void CloseReadFile();
+      int ReadChunk(uint32_t offset, uint32_t size);
+      uint16_t ChunkSize(uint16_t connectionHandle) const;
+      int SendReadData(uint16_t connectionHandle, int8_t status, uint32_t offset, uint32_t length);
+      void Stream();
+      static void StreamCallback(ble_npl_event* event);
     };
   }
 }
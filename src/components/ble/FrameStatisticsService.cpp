@@ -0,0 +1,88 @@
+#include "components/ble/FrameStatisticsService.h"
+#include <cstring>
+#include "components/display/FrameStatistics.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  // 0006yyxx-78fc-48fe-8e23-433b3a1942d0
+  constexpr ble_uuid128_t CharUuid(uint8_t x, uint8_t y) {
+    return ble_uuid128_t {.u = {.type = BLE_UUID_TYPE_128},
+                          .value = {0xd0, 0x42, 0x19, 0x3a, 0x3b, 0x43, 0x23, 0x8e, 0xfe, 0x48, 0xfc, 0x78, x, y, 0x06, 0x00}};
+  }
+
+  // 00060000-78fc-48fe-8e23-433b3a1942d0
+  constexpr ble_uuid128_t BaseUuid() {
+    return CharUuid(0x00, 0x00);
+  }
+
+  constexpr ble_uuid128_t frameStatisticsServiceUuid {BaseUuid()};
+  constexpr ble_uuid128_t summaryCharUuid {CharUuid(0x01, 0x00)};
+
+  int FrameStatisticsServiceCallback(uint16_t /*conn_handle*/, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    auto* frameStatisticsService = static_cast<FrameStatisticsService*>(arg);
+    return frameStatisticsService->OnFrameStatisticsRequested(attr_handle, ctxt);
+  }
+
+  template <typename T>
+  uint8_t* Append(uint8_t* buffer, T value) {
+    std::memcpy(buffer, &value, sizeof(T));
+    return buffer + sizeof(T);
+  }
+}
+
+FrameStatisticsService::FrameStatisticsService(FrameStatistics& frameStatistics)
+  : frameStatistics {frameStatistics},
+    characteristicDefinition {{.uuid = &summaryCharUuid.u,
+                               .access_cb = FrameStatisticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                               .val_handle = &summaryHandle},
+                              {0}},
+    serviceDefinition {
+      {.type = BLE_GATT_SVC_TYPE_PRIMARY, .uuid = &frameStatisticsServiceUuid.u, .characteristics = characteristicDefinition},
+      {0},
+    } {
+}
+
+void FrameStatisticsService::Init() {
+  int res = 0;
+  res = ble_gatts_count_cfg(serviceDefinition);
+  ASSERT(res == 0);
+
+  res = ble_gatts_add_svcs(serviceDefinition);
+  ASSERT(res == 0);
+}
+
+int FrameStatisticsService::OnFrameStatisticsRequested(uint16_t attributeHandle, ble_gatt_access_ctxt* context) {
+  if (attributeHandle != summaryHandle) {
+    return 0;
+  }
+
+  // Any write clears the rolling window and the frame counter
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    frameStatistics.Reset();
+    return 0;
+  }
+
+  // Little endian: totalFrames (u32), nbFrames, renderTimeAverage, renderTimeMax (ms), spiBlockedTimeAverage, spiBlockedTimeMax (us),
+  // flushCountAverage (u16), lvglTaskCount (u8), byteCountAverage (u32), render time histogram (u16 per bucket)
+  const auto summary = frameStatistics.GetSummary();
+  uint8_t buffer[4 + 6 * 2 + 1 + 4 + FrameStatistics::nbBuckets * 2];
+  uint8_t* ptr = buffer;
+  ptr = Append(ptr, summary.totalFrames);
+  ptr = Append(ptr, summary.nbFrames);
+  ptr = Append(ptr, summary.renderTimeAverage);
+  ptr = Append(ptr, summary.renderTimeMax);
+  ptr = Append(ptr, summary.spiBlockedTimeAverage);
+  ptr = Append(ptr, summary.spiBlockedTimeMax);
+  ptr = Append(ptr, summary.flushCountAverage);
+  ptr = Append(ptr, summary.lvglTaskCount);
+  ptr = Append(ptr, summary.byteCountAverage);
+  for (auto count : summary.renderTimeHistogram) {
+    ptr = Append(ptr, count);
+  }
+
+  int res = os_mbuf_append(context->om, buffer, ptr - buffer);
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#define min // workaround: nimble's min/max macros conflict with libstdc++
+#define max
+#include <host/ble_gap.h>
+#undef max
+#undef min
+
+namespace Pinetime {
+  namespace Controllers {
+    class FrameStatistics;
+
+    class FrameStatisticsService {
+    public:
+      explicit FrameStatisticsService(FrameStatistics& frameStatistics);
+      void Init();
+      int OnFrameStatisticsRequested(uint16_t attributeHandle, ble_gatt_access_ctxt* context);
+
+    private:
+      FrameStatistics& frameStatistics;
+
+      struct ble_gatt_chr_def characteristicDefinition[2];
+      struct ble_gatt_svc_def serviceDefinition[2];
+
+      uint16_t summaryHandle;
+    };
+  }
+}
@@ -30,13 +30,14 @@ NimbleController::NimbleController(Pinetime::System::SystemTask& systemTask,
                                    Pinetime::Drivers::SpiNorFlash& spiNorFlash,
                                    HeartRateController& heartRateController,
                                    MotionController& motionController,
-                                   FS& fs)
+                                   FS& fs,
+                                   FrameStatistics& frameStatistics)
   : systemTask {systemTask},
     bleController {bleController},
     dateTimeController {dateTimeController},
     spiNorFlash {spiNorFlash},
     fs {fs},
-    dfuService {systemTask, bleController, spiNorFlash},
+    dfuService {systemTask, bleController, spiNorFlash, connectionProfiles},
 
     currentTimeClient {dateTimeController},
     anService {systemTask, notificationManager},
@@ -48,7 +49,8 @@ NimbleController::NimbleController(Pinetime::System::SystemTask& systemTask,
     immediateAlertService {systemTask, notificationManager},
     heartRateService {*this, heartRateController},
     motionService {*this, motionController},
-    fsService {systemTask, fs},
+    fsService {systemTask, fs, connectionProfiles},
+    frameStatisticsService {frameStatistics},
     serviceDiscovery({&currentTimeClient, &alertNotificationClient}) {
 }
 
@@ -85,6 +87,8 @@ void NimbleController::Init() {
   ble_svc_gap_init();
   ble_svc_gatt_init();
 
+  connectionProfiles.Init();
+
   deviceInformationService.Init();
   currentTimeClient.Init();
   currentTimeService.Init();
@@ -98,6 +102,7 @@ void NimbleController::Init() {
   heartRateService.Init();
   motionService.Init();
   fsService.Init();
+  frameStatisticsService.Init();
 
   int rc;
   rc = ble_hs_util_ensure_addr(0);
@@ -206,6 +211,7 @@ int NimbleController::OnGAPEvent(ble_gap_event* event) {
         StartAdvertising();
       } else {
         connectionHandle = event->connect.conn_handle;
+        connectionProfiles.OnConnect(connectionHandle);
         bleController.Connect();
         systemTask.PushMessage(Pinetime::System::Messages::BleConnected);
         // Service discovery is deferred via systemtask
@@ -223,6 +229,9 @@ int NimbleController::OnGAPEvent(ble_gap_event* event) {
 
       currentTimeClient.Reset();
       alertNotificationClient.Reset();
+      fsService.OnDisconnect();
+      fs.LogClientStatistics();
+      connectionProfiles.OnDisconnect();
       connectionHandle = BLE_HS_CONN_HANDLE_NONE;
       if (bleController.IsConnected()) {
         bleController.Disconnect();
@@ -235,6 +244,9 @@ int NimbleController::OnGAPEvent(ble_gap_event* event) {
       /* The central has updated the connection parameters. */
       NRF_LOG_INFO("Update event : BLE_GAP_EVENT_CONN_UPDATE");
       NRF_LOG_INFO("update status=%0X ", event->conn_update.status);
+      if (event->conn_update.status == 0) {
+        connectionProfiles.OnConnectionUpdated(event->conn_update.conn_handle);
+      }
       break;
 
     case BLE_GAP_EVENT_CONN_UPDATE_REQ:
@@ -334,6 +346,16 @@ int NimbleController::OnGAPEvent(ble_gap_event* event) {
       }
       break;
 
+    case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE:
+      NRF_LOG_INFO("PHY Update event; status=%d tx_phy=%d rx_phy=%d",
+                   event->phy_updated.status,
+                   event->phy_updated.tx_phy,
+                   event->phy_updated.rx_phy);
+      if (event->phy_updated.status == 0) {
+        connectionProfiles.OnPhyUpdated(event->phy_updated.tx_phy, event->phy_updated.rx_phy);
+      }
+      break;
+
     case BLE_GAP_EVENT_MTU:
       NRF_LOG_INFO("MTU Update event; conn_handle=%d cid=%d mtu=%d", event->mtu.conn_handle, event->mtu.channel_id, event->mtu.value);
       break;
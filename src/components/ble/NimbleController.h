@@ -10,11 +10,13 @@
 #include "components/ble/AlertNotificationClient.h"
 #include "components/ble/AlertNotificationService.h"
 #include "components/ble/BatteryInformationService.h"
+#include "components/ble/ConnectionProfiles.h"
 #include "components/ble/CurrentTimeClient.h"
 #include "components/ble/CurrentTimeService.h"
 #include "components/ble/DeviceInformationService.h"
 #include "components/ble/DfuService.h"
 #include "components/ble/FSService.h"
+#include "components/ble/FrameStatisticsService.h"
 #include "components/ble/HeartRateService.h"
 #include "components/ble/ImmediateAlertService.h"
 #include "components/ble/MusicService.h"
@@ -36,6 +38,7 @@ namespace Pinetime {
   namespace Controllers {
     class Ble;
     class DateTime;
+    class FrameStatistics;
     class NotificationManager;
 
     class NimbleController {
@@ -49,7 +52,8 @@ namespace Pinetime {
                        Pinetime::Drivers::SpiNorFlash& spiNorFlash,
                        HeartRateController& heartRateController,
                        MotionController& motionController,
-                       FS& fs);
+                       FS& fs,
+                       FrameStatistics& frameStatistics);
       void Init();
       void StartAdvertising();
       int OnGAPEvent(ble_gap_event* event);
@@ -67,6 +71,10 @@ namespace Pinetime {
         return anService;
       };
 
+      Pinetime::Controllers::FSService& fs() {
+        return fsService;
+      };
+
       Pinetime::Controllers::SimpleWeatherService& weather() {
         return weatherService;
       };
@@ -91,6 +99,7 @@ namespace Pinetime {
       DateTime& dateTimeController;
       Pinetime::Drivers::SpiNorFlash& spiNorFlash;
       FS& fs;
+      ConnectionProfiles connectionProfiles;
       DfuService dfuService;
 
       DeviceInformationService deviceInformationService;
@@ -106,6 +115,7 @@ namespace Pinetime {
       HeartRateService heartRateService;
       MotionService motionService;
       FSService fsService;
+      FrameStatisticsService frameStatisticsService;
       ServiceDiscovery serviceDiscovery;
 
       uint8_t addrType;
@@ -0,0 +1,57 @@
+#include "components/display/FrameStatistics.h"
+#include <FreeRTOS.h>
+#include <task.h>
+#include <algorithm>
+
+using namespace Pinetime::Controllers;
+
+void FrameStatistics::AddFrame(const Frame& frame) {
+  taskENTER_CRITICAL();
+  frames[0] = frame;
+  frames++;
+  nbFrames = std::min<uint16_t>(nbFrames + 1, windowSize);
+  totalFrames++;
+  taskEXIT_CRITICAL();
+}
+
+FrameStatistics::Summary FrameStatistics::GetSummary() const {
+  Summary summary;
+  uint32_t renderTimeSum = 0;
+  uint32_t spiBlockedTimeSum = 0;
+  uint32_t flushCountSum = 0;
+  uint32_t byteCountSum = 0;
+
+  taskENTER_CRITICAL();
+  summary.totalFrames = totalFrames;
+  summary.nbFrames = nbFrames;
+  // The oldest frames are at the current index, the last one just before it
+  for (size_t i = windowSize - nbFrames; i < windowSize; i++) {
+    const Frame& frame = frames[i];
+    renderTimeSum += frame.renderTime;
+    spiBlockedTimeSum += frame.spiBlockedTime;
+    flushCountSum += frame.flushCount;
+    byteCountSum += frame.byteCount;
+    summary.renderTimeMax = std::max(summary.renderTimeMax, frame.renderTime);
+    summary.spiBlockedTimeMax = std::max(summary.spiBlockedTimeMax, frame.spiBlockedTime);
+    summary.lvglTaskCount = frame.lvglTaskCount;
+
+    auto bucket = std::upper_bound(renderTimeBuckets.begin(), renderTimeBuckets.end(), frame.renderTime);
+    summary.renderTimeHistogram[bucket - renderTimeBuckets.begin()]++;
+  }
+  taskEXIT_CRITICAL();
+
+  if (summary.nbFrames > 0) {
+    summary.renderTimeAverage = renderTimeSum / summary.nbFrames;
+    summary.spiBlockedTimeAverage = spiBlockedTimeSum / summary.nbFrames;
+    summary.flushCountAverage = flushCountSum / summary.nbFrames;
+    summary.byteCountAverage = byteCountSum / summary.nbFrames;
+  }
+  return summary;
+}
+
+void FrameStatistics::Reset() {
+  taskENTER_CRITICAL();
+  nbFrames = 0;
+  totalFrames = 0;
+  taskEXIT_CRITICAL();
+}
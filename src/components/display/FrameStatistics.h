@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "utility/CircularBuffer.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    // Timing of the frames rendered by LVGL, written by the display task and read by the UI and BLE
+    class FrameStatistics {
+    public:
+      struct Frame {
+        uint16_t renderTime = 0;     // ms
+        uint16_t spiBlockedTime = 0; // us, time the display task waited for the SPI bus (saturates)
+        uint16_t flushCount = 0;
+        uint8_t lvglTaskCount = 0;
+        uint32_t byteCount = 0;
+      };
+
+      // Upper limits (ms) of the render time histogram buckets, the last bucket holds the longer frames
+      static constexpr std::array<uint16_t, 7> renderTimeBuckets {5, 10, 20, 40, 80, 160, 320};
+      static constexpr size_t nbBuckets = renderTimeBuckets.size() + 1;
+
+      struct Summary {
+        uint32_t totalFrames = 0;
+        uint16_t nbFrames = 0; // frames in the rolling window
+        uint16_t renderTimeAverage = 0;
+        uint16_t renderTimeMax = 0;
+        uint16_t spiBlockedTimeAverage = 0;
+        uint16_t spiBlockedTimeMax = 0;
+        uint16_t flushCountAverage = 0;
+        uint8_t lvglTaskCount = 0;
+        uint32_t byteCountAverage = 0;
+        std::array<uint16_t, nbBuckets> renderTimeHistogram {}; // frames of the rolling window
+      };
+
+      void AddFrame(const Frame& frame);
+      Summary GetSummary() const;
+      void Reset();
+
+    private:
+      static constexpr size_t windowSize = 32;
+      Utility::CircularBuffer<Frame, windowSize> frames = {};
+      uint16_t nbFrames = 0;
+      uint32_t totalFrames = 0;
+    };
+  }
+}
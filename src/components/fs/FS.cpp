@@ -1,7 +1,12 @@
 #include "components/fs/FS.h"
 #include <cstring>
+#include <nrf.h>
 #include <littlefs/lfs.h>
 #include <lvgl/lvgl.h>
+#include <task.h>
+#include <nrf_log.h>
+#include "nrf_assert.h"
+#include "utility/ElapsedTime.h"
 
 using namespace Pinetime::Controllers;
 
@@ -20,17 +25,24 @@ FS::FS(Pinetime::Drivers::SpiNorFlash& driver)
       .block_count = size / blockSize,
       .block_cycles = 1000u,
 
-      .cache_size = 16,
-      .lookahead_size = 16,
+      .cache_size = smallRamCacheSize,
+      .lookahead_size = smallRamLookaheadSize,
 
       .name_max = 50,
-      .attr_max = 50,
+      .attr_max = maxAttributeSize,
     } {
+  mutex = xSemaphoreCreateMutex();
+  ASSERT(mutex != nullptr);
 }
 
 void FS::Init() {
+  Lock lock(*this);
+  ApplyProfile(SelectProfile());
+
+  flashFailures = FlashFailures();
 
   // try mount
+  const Utility::ElapsedTime mountTime;
   int err = lfs_mount(&lfs, &lfsConfig);
 
   // reformat if we can't mount the filesystem
@@ -42,70 +54,296 @@ void FS::Init() {
       return;
     }
   }
+  mounted = true;
+  statistics.mountTime = mountTime.Microseconds();
+  NRF_LOG_INFO("[FS] Mounted in %lu us, %s profile (%d B of caches)",
+               statistics.mountTime,
+               ProfileToString(profile),
+               static_cast<int>(GetCacheBytes()));
 
 #ifndef PINETIME_IS_RECOVERY
   VerifyResource();
 #endif
 }
 
+FS::Lock::Lock(FS& fs) : fs {fs} {
+  fs.Acquire();
+}
+
+FS::Lock::~Lock() {
+  fs.Release();
+}
+
+void FS::RegisterClient(Clients client, TaskHandle_t task) {
+  clientTasks[static_cast<uint8_t>(client)] = task;
+}
+
+FS::Clients FS::CurrentClient() const {
+  const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  for (size_t i = 0; i < nbClients; i++) {
+    if (clientTasks[i] == task) {
+      return static_cast<Clients>(i);
+    }
+  }
+  return Clients::Other;
+}
+
+void FS::Acquire() {
+  const Clients client = CurrentClient();
+  auto& clientStats = clientStatistics[static_cast<uint8_t>(client)];
+  if (xSemaphoreTake(mutex, 0) == pdTRUE) {
+    clientStats.operations++;
+    return;
+  }
+
+  // Waiting tasks are queued by priority: the display task (priority 0) would get the mutex after every other client,
+  // it waits at their priority instead. Its priority is restored as soon as it holds the mutex, priority inheritance
+  // then boosts it if needed.
+  const Utility::ElapsedTime wait;
+  const UBaseType_t priority = uxTaskPriorityGet(nullptr);
+  const bool boosted = (client == Clients::Display) && (priority < displayWaitPriority);
+  if (boosted) {
+    vTaskPrioritySet(nullptr, displayWaitPriority);
+  }
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  if (boosted) {
+    vTaskPrioritySet(nullptr, priority);
+  }
+
+  const uint32_t waitTime = wait.Microseconds();
+  clientStats.operations++;
+  clientStats.contended++;
+  clientStats.waitTime += waitTime;
+  if (waitTime > clientStats.maxWaitTime) {
+    clientStats.maxWaitTime = waitTime;
+  }
+}
+
+void FS::Release() {
+  xSemaphoreGive(mutex);
+}
+
+const char* FS::ClientToString(Clients client) {
+  switch (client) {
+    case Clients::System:
+      return "System";
+    case Clients::Ble:
+      return "BLE";
+    case Clients::Display:
+      return "Display";
+    default:
+      return "Other";
+  }
+}
+
+void FS::LogClientStatistics() const {
+  for (size_t i = 0; i < nbClients; i++) {
+    const auto& clientStats = clientStatistics[i];
+    NRF_LOG_INFO("[FS] %s: %lu operations, %lu waited (%lu us, max %lu us)",
+                 ClientToString(static_cast<Clients>(i)),
+                 clientStats.operations,
+                 clientStats.contended,
+                 clientStats.waitTime,
+                 clientStats.maxWaitTime);
+  }
+}
+
+FS::Profiles FS::SelectProfile() {
+#if defined(LITTLEFS_PROFILE_THROUGHPUT)
+  return Profiles::Throughput;
+#elif defined(LITTLEFS_PROFILE_AUTO)
+  return (xPortGetFreeHeapSize() >= throughputProfileMinFreeHeap) ? Profiles::Throughput : Profiles::SmallRam;
+#else
+  return Profiles::SmallRam;
+#endif
+}
+
+void FS::ApplyProfile(Profiles newProfile) {
+  // The caches are allocated by lfs_mount(), the profile can only change while the file system is unmounted
+  profile = newProfile;
+  switch (profile) {
+    case Profiles::Throughput:
+      lfsConfig.cache_size = throughputCacheSize;
+      lfsConfig.lookahead_size = throughputLookaheadSize;
+      break;
+    default:
+      lfsConfig.cache_size = smallRamCacheSize;
+      lfsConfig.lookahead_size = smallRamLookaheadSize;
+      break;
+  }
+}
+
+const char* FS::ProfileToString(Profiles profile) {
+  switch (profile) {
+    case Profiles::Throughput:
+      return "Throughput";
+    default:
+      return "SmallRam";
+  }
+}
+
 void FS::VerifyResource() {
   // validate the resource metadata
   resourcesValid = true;
 }
 
 int FS::FileOpen(lfs_file_t* file_p, const char* fileName, const int flags) {
+  Lock lock(*this);
   return lfs_file_open(&lfs, file_p, fileName, flags);
 }
 
 int FS::FileClose(lfs_file_t* file_p) {
+  Lock lock(*this);
   return lfs_file_close(&lfs, file_p);
 }
 
 int FS::FileRead(lfs_file_t* file_p, uint8_t* buff, uint32_t size) {
+  Lock lock(*this);
   return lfs_file_read(&lfs, file_p, buff, size);
 }
 
 int FS::FileWrite(lfs_file_t* file_p, const uint8_t* buff, uint32_t size) {
+  Lock lock(*this);
   return lfs_file_write(&lfs, file_p, buff, size);
 }
 
 int FS::FileSeek(lfs_file_t* file_p, uint32_t pos) {
+  Lock lock(*this);
   return lfs_file_seek(&lfs, file_p, pos, LFS_SEEK_SET);
 }
 
+int FS::FileSize(lfs_file_t* file_p) {
+  Lock lock(*this);
+  return lfs_file_size(&lfs, file_p);
+}
+
 int FS::FileDelete(const char* fileName) {
+  Lock lock(*this);
   return lfs_remove(&lfs, fileName);
 }
 
 int FS::DirOpen(const char* path, lfs_dir_t* lfs_dir) {
+  Lock lock(*this);
   return lfs_dir_open(&lfs, lfs_dir, path);
 }
 
 int FS::DirClose(lfs_dir_t* lfs_dir) {
+  Lock lock(*this);
   return lfs_dir_close(&lfs, lfs_dir);
 }
 
 int FS::DirRead(lfs_dir_t* dir, lfs_info* info) {
+  Lock lock(*this);
   return lfs_dir_read(&lfs, dir, info);
 }
 
 int FS::DirRewind(lfs_dir_t* dir) {
+  Lock lock(*this);
   return lfs_dir_rewind(&lfs, dir);
 }
 
 int FS::DirCreate(const char* path) {
+  Lock lock(*this);
   return lfs_mkdir(&lfs, path);
 }
 
 int FS::Rename(const char* oldPath, const char* newPath) {
+  Lock lock(*this);
   return lfs_rename(&lfs, oldPath, newPath);
 }
 
 int FS::Stat(const char* path, lfs_info* info) {
+  Lock lock(*this);
   return lfs_stat(&lfs, path, info);
 }
 
+int FS::GetAttribute(const char* path, uint8_t type, void* buffer, uint32_t size) {
+  Lock lock(*this);
+  return lfs_getattr(&lfs, path, type, buffer, size);
+}
+
+int FS::SetAttribute(const char* path, uint8_t type, const void* buffer, uint32_t size) {
+  Lock lock(*this);
+  return lfs_setattr(&lfs, path, type, buffer, size);
+}
+
+int FS::RemoveAttribute(const char* path, uint8_t type) {
+  Lock lock(*this);
+  return lfs_removeattr(&lfs, path, type);
+}
+
+bool FS::PreErase() {
+  Lock lock(*this);
+  FinishPreErase();
+  if (!mounted || nbPreErased >= preEraseTarget || flashDriver.IsSleeping()) {
+    return false;
+  }
+
+  if (!usedBlocksValid) {
+    usedBlocks.fill(0);
+    if (lfs_fs_traverse(&lfs, MarkUsedBlock, this) < 0) {
+      return false;
+    }
+    usedBlocksValid = true;
+  }
+
+  for (size_t i = 0; i < nbBlocks; i++) {
+    const lfs_block_t block = (nextBlockHint + i) % nbBlocks;
+    if (TestBlock(usedBlocks, block) || TestBlock(erasedBlocks, block)) {
+      continue;
+    }
+
+    // The erase is only started here: the mutex is released while the flash erases the block, and the erase is
+    // checked by the next operation that uses the flash, in FinishPreErase()
+    flashDriver.WaitReady();
+    flashFailuresAtPreErase = FlashFailures();
+    flashDriver.BeginSectorErase(startAddress + (block * blockSize));
+    preEraseBlock = block;
+    preErasePending = true;
+    return true;
+  }
+  return false;
+}
+
+void FS::FinishPreErase() {
+  if (!preErasePending) {
+    return;
+  }
+  preErasePending = false;
+  flashDriver.WaitReady();
+  const uint32_t failures = FlashFailures();
+  if (failures != flashFailuresAtPreErase) {
+    // littlefs did not issue this erase, its failure is not reported at the next sync
+    flashFailures += failures - flashFailuresAtPreErase;
+    return;
+  }
+  SetBlock(erasedBlocks, preEraseBlock);
+  nbPreErased++;
+  statistics.preErases++;
+#ifdef FS_BENCHMARK
+  eraseCounts[preEraseBlock]++;
+#endif
+}
+
+int FS::MarkUsedBlock(void* context, lfs_block_t block) {
+  auto* fs = static_cast<FS*>(context);
+  if (block < nbBlocks) {
+    SetBlock(fs->usedBlocks, block);
+  }
+  return 0;
+}
+
+uint32_t FS::FlashFailures() const {
+  const auto& flashStatistics = flashDriver.GetWriteStatistics();
+  return flashStatistics.programFailures + flashStatistics.eraseFailures;
+}
+
+uint32_t FS::FlashWaitTime() const {
+  return flashDriver.GetWriteStatistics().blockedTime;
+}
+
 lfs_ssize_t FS::GetFSSize() {
+  Lock lock(*this);
   return lfs_fs_size(&lfs);
 }
 
@@ -113,28 +351,90 @@ lfs_ssize_t FS::GetFSSize() {
 
     ----------- Interface between littlefs and SpiNorFlash -----------
 
+    The operations fail with LFS_ERR_IO while the flash is in deep power-down (between SpiNorFlash::Sleep() and
+    Wakeup()), the flash would not answer.
 */
-int FS::SectorSync(const struct lfs_config* /*c*/) {
+int FS::SectorSync(const struct lfs_config* c) {
+  Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
+  lfs.FinishPreErase();
+  // The driver refuses the operations while the flash sleeps, they did not happen
+  if (lfs.flashDriver.IsSleeping()) {
+    return LFS_ERR_IO;
+  }
+  // Programs and erases return as soon as they are started: littlefs only relies on them once it syncs
+  const uint32_t waitBefore = lfs.FlashWaitTime();
+  lfs.flashDriver.WaitReady();
+  lfs.statistics.flashWaitTime += lfs.FlashWaitTime() - waitBefore;
+  const uint32_t failures = lfs.FlashFailures();
+  if (failures != lfs.flashFailures) {
+    lfs.flashFailures = failures;
+    return -1;
+  }
   return 0;
 }
 
 int FS::SectorErase(const struct lfs_config* c, lfs_block_t block) {
   Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
+  if (lfs.flashDriver.IsSleeping()) {
+    return LFS_ERR_IO;
+  }
   const size_t address = startAddress + (block * blockSize);
-  lfs.flashDriver.SectorErase(address);
-  return lfs.flashDriver.EraseFailed() ? -1 : 0;
+  lfs.FinishPreErase();
+  lfs.usedBlocksValid = false;
+  lfs.nextBlockHint = (block + 1) % nbBlocks;
+  if (TestBlock(lfs.erasedBlocks, block)) {
+    // Erased by PreErase() and not programmed since
+    ClearBlock(lfs.erasedBlocks, block);
+    lfs.nbPreErased--;
+    lfs.statistics.erasesSkipped++;
+    return 0;
+  }
+
+  // Only waits for the previous program or erase
+  const uint32_t waitBefore = lfs.FlashWaitTime();
+  lfs.flashDriver.BeginSectorErase(address);
+  lfs.statistics.erases++;
+  lfs.statistics.flashWaitTime += lfs.FlashWaitTime() - waitBefore;
+#ifdef FS_BENCHMARK
+  lfs.eraseCounts[block]++;
+#endif
+  return 0;
 }
 
 int FS::SectorProg(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer, lfs_size_t size) {
   Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
+  if (lfs.flashDriver.IsSleeping()) {
+    return LFS_ERR_IO;
+  }
   const size_t address = startAddress + (block * blockSize) + off;
+  lfs.FinishPreErase();
+  lfs.usedBlocksValid = false;
+  if (TestBlock(lfs.erasedBlocks, block)) {
+    ClearBlock(lfs.erasedBlocks, block);
+    lfs.nbPreErased--;
+  }
+  const Utility::ElapsedTime programTime;
+  const uint32_t waitBefore = lfs.FlashWaitTime();
   lfs.flashDriver.Write(address, (uint8_t*) buffer, size);
-  return lfs.flashDriver.ProgramFailed() ? -1 : 0;
+  lfs.statistics.programs++;
+  lfs.statistics.bytesProgrammed += size;
+  lfs.statistics.programTime += programTime.Microseconds();
+  lfs.statistics.flashWaitTime += lfs.FlashWaitTime() - waitBefore;
+  return 0;
 }
 
 int FS::SectorRead(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer, lfs_size_t size) {
   Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
+  if (lfs.flashDriver.IsSleeping()) {
+    return LFS_ERR_IO;
+  }
   const size_t address = startAddress + (block * blockSize) + off;
+  const Utility::ElapsedTime readTime;
+  const uint32_t waitBefore = lfs.FlashWaitTime();
   lfs.flashDriver.Read(address, static_cast<uint8_t*>(buffer), size);
+  lfs.statistics.reads++;
+  lfs.statistics.bytesRead += size;
+  lfs.statistics.readTime += readTime.Microseconds();
+  lfs.statistics.flashWaitTime += lfs.FlashWaitTime() - waitBefore;
   return 0;
 }
@@ -1,22 +1,63 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include "drivers/SpiNorFlash.h"
 #include <littlefs/lfs.h>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
 
 namespace Pinetime {
   namespace Controllers {
     class FS {
     public:
+      // littlefs cache and lookahead sizes, chosen when the file system is mounted.
+      // SmallRam keeps the buffers at their minimum, Throughput trades RAM for fewer and larger flash transactions.
+      enum class Profiles : uint8_t { SmallRam, Throughput };
+
+      // Flash operations issued by littlefs since boot, times in us
+      struct Statistics {
+        uint32_t reads = 0;
+        uint32_t bytesRead = 0;
+        uint32_t readTime = 0;
+        uint32_t programs = 0;
+        uint32_t bytesProgrammed = 0;
+        uint32_t programTime = 0;
+        uint32_t erases = 0;
+        // Part of the callbacks spent waiting for a program or an erase to complete: erases only start in their
+        // callback, their duration is charged to the read, program or sync that waits for them
+        uint32_t flashWaitTime = 0;
+        uint32_t mountTime = 0;
+        uint32_t preErases = 0;
+        uint32_t erasesSkipped = 0;
+      };
+
+      // Tasks using the file system. Operations are serialized by a mutex; the display task waits for it at the priority
+      // of the other clients so that a BLE transfer does not stall the UI.
+      enum class Clients : uint8_t { System, Ble, Display, Other };
+      static constexpr size_t nbClients = 4;
+
+      // Operations of a client since boot, times in us
+      struct ClientStatistics {
+        uint32_t operations = 0;
+        uint32_t contended = 0;
+        uint32_t waitTime = 0;
+        uint32_t maxWaitTime = 0;
+      };
+
       FS(Pinetime::Drivers::SpiNorFlash&);
 
       void Init();
+      // Called once for each client task, operations from unregistered tasks are accounted to Clients::Other
+      void RegisterClient(Clients client, TaskHandle_t task);
 
       int FileOpen(lfs_file_t* file_p, const char* fileName, const int flags);
       int FileClose(lfs_file_t* file_p);
       int FileRead(lfs_file_t* file_p, uint8_t* buff, uint32_t size);
       int FileWrite(lfs_file_t* file_p, const uint8_t* buff, uint32_t size);
       int FileSeek(lfs_file_t* file_p, uint32_t pos);
+      int FileSize(lfs_file_t* file_p);
 
       int FileDelete(const char* fileName);
 
@@ -26,9 +67,23 @@ namespace Pinetime {
       int DirRewind(lfs_dir_t* dir);
       int DirCreate(const char* path);
 
+      // Starts the erase of one free block ahead of the littlefs allocator, so that a later write does not wait for the
+      // erase. Does not wait for the erase to complete. Returns false when there is nothing left to erase, or when the
+      // flash is in deep power-down: like every file system operation, it needs the flash and the SPI bus awake.
+      bool PreErase();
+
+      size_t PreErasedBlocks() const {
+        return nbPreErased;
+      }
+
       lfs_ssize_t GetFSSize();
       int Rename(const char* oldPath, const char* newPath);
       int Stat(const char* path, lfs_info* info);
+      // littlefs custom attributes, stored in the metadata of the directory: setting one does not rewrite the file
+      int GetAttribute(const char* path, uint8_t type, void* buffer, uint32_t size);
+      int SetAttribute(const char* path, uint8_t type, const void* buffer, uint32_t size);
+      int RemoveAttribute(const char* path, uint8_t type);
+      static constexpr size_t maxAttributeSize = 50;
       void VerifyResource();
 
       static size_t getSize() {
@@ -39,6 +94,36 @@ namespace Pinetime {
         return blockSize;
       }
 
+      const Statistics& GetStatistics() const {
+        return statistics;
+      }
+
+      const ClientStatistics& GetClientStatistics(Clients client) const {
+        return clientStatistics[static_cast<uint8_t>(client)];
+      }
+
+      static const char* ClientToString(Clients client);
+      void LogClientStatistics() const;
+
+      Profiles GetProfile() const {
+        return profile;
+      }
+
+      static const char* ProfileToString(Profiles profile);
+
+      // Heap used by littlefs with the current profile: read and program caches plus lookahead buffer,
+      // each open file allocates another cache
+      size_t GetCacheBytes() const {
+        return 2 * lfsConfig.cache_size + lfsConfig.lookahead_size;
+      }
+
+#ifdef FS_BENCHMARK
+      // Erases of each block since boot
+      const std::array<uint16_t, 0x34C000 / 4096>& GetEraseCounts() const {
+        return eraseCounts;
+      }
+#endif
+
     private:
       Pinetime::Drivers::SpiNorFlash& flashDriver;
 
@@ -68,8 +153,86 @@ namespace Pinetime {
       static constexpr size_t size = 0x34C000;
       static constexpr size_t blockSize = 4096;
 
+      // Auto profile: free heap needed at boot to pick the Throughput profile
+      static constexpr size_t throughputProfileMinFreeHeap = 16 * 1024;
+      static constexpr lfs_size_t smallRamCacheSize = 16;
+      static constexpr lfs_size_t smallRamLookaheadSize = 16;
+      static constexpr lfs_size_t throughputCacheSize = 256;
+      // One bit per block, large enough to track every block of the file system in a single scan
+      static constexpr lfs_size_t throughputLookaheadSize = ((size / blockSize) + 63) / 64 * 8;
+
+      // Blocks kept erased in advance, enough for a few settings saves or a small resource upload
+      static constexpr size_t preEraseTarget = 32;
+      static constexpr size_t nbBlocks = size / blockSize;
+      using BlockBitmap = std::array<uint32_t, (nbBlocks + 31) / 32>;
+
+      static bool TestBlock(const BlockBitmap& bitmap, lfs_block_t block) {
+        return (bitmap[block / 32] & (1u << (block % 32))) != 0;
+      }
+
+      static void SetBlock(BlockBitmap& bitmap, lfs_block_t block) {
+        bitmap[block / 32] |= (1u << (block % 32));
+      }
+
+      static void ClearBlock(BlockBitmap& bitmap, lfs_block_t block) {
+        bitmap[block / 32] &= ~(1u << (block % 32));
+      }
+
+      static int MarkUsedBlock(void* context, lfs_block_t block);
+      // Checks the erase started by PreErase(), before littlefs uses the flash again
+      void FinishPreErase();
+
+      uint32_t FlashFailures() const;
+      uint32_t FlashWaitTime() const;
+
+      static Profiles SelectProfile();
+      void ApplyProfile(Profiles newProfile);
+
+      class Lock {
+      public:
+        explicit Lock(FS& fs);
+        ~Lock();
+        Lock(const Lock&) = delete;
+        Lock& operator=(const Lock&) = delete;
+
+      private:
+        FS& fs;
+      };
+
+      Clients CurrentClient() const;
+      void Acquire();
+      void Release();
+
+      // Priority of the display task while it waits for the mutex: the same as the BLE host and system tasks, so that it
+      // is queued with them instead of behind them, and below the NimBLE link layer task
+      static constexpr UBaseType_t displayWaitPriority = 1;
+
+      bool mounted = false;
+      // Program and erase failures reported by the flash driver at the last sync
+      uint32_t flashFailures = 0;
       bool resourcesValid = false;
-      const struct lfs_config lfsConfig;
+      Statistics statistics;
+      // Blocks referenced by the file system at the last traversal, valid until littlefs writes again.
+      // One bit per block: 27 words (108 B) for the 844 blocks, the same for erasedBlocks.
+      BlockBitmap usedBlocks {};
+      bool usedBlocksValid = false;
+      // Free blocks erased by PreErase() and not programmed since
+      BlockBitmap erasedBlocks {};
+      size_t nbPreErased = 0;
+      // Block whose erase was started by PreErase() and not checked yet
+      bool preErasePending = false;
+      lfs_block_t preEraseBlock = 0;
+      uint32_t flashFailuresAtPreErase = 0;
+      // littlefs allocates blocks in increasing order, starting after the last one it erased
+      lfs_block_t nextBlockHint = 0;
+      SemaphoreHandle_t mutex = nullptr;
+      std::array<TaskHandle_t, nbClients> clientTasks {};
+      std::array<ClientStatistics, nbClients> clientStatistics;
+#ifdef FS_BENCHMARK
+      std::array<uint16_t, size / blockSize> eraseCounts {};
+#endif
+      Profiles profile = Profiles::SmallRam;
+      struct lfs_config lfsConfig;
 
       lfs_t lfs;
 
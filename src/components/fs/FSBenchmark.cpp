@@ -0,0 +1,238 @@
+#include "components/fs/FSBenchmark.h"
+#include "components/fs/TimeSeries.h"
+#include <algorithm>
+#include <array>
+#include <task.h>
+#include <nrf_log.h>
+#include "utility/ElapsedTime.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  uint8_t buffer[512];
+  lfs_info info;
+  std::array<uint32_t, 64> latencies;
+}
+
+FSBenchmark::FSBenchmark(FS& fs) : fs {fs} {
+}
+
+void FSBenchmark::Run() {
+  NRF_LOG_INFO("[FSBenchmark] %s profile, %d B of caches, mounted in %lu us",
+               FS::ProfileToString(fs.GetProfile()),
+               static_cast<int>(fs.GetCacheBytes()),
+               fs.GetStatistics().mountTime);
+  fs.DirCreate(directory);
+
+  SettingsSaves();
+  SettingsJournal();
+  ResourceUpload();
+  ResourceReads("Resource reads (16 B)", 16);
+  ResourceReads("Resource reads (512 B)", sizeof(buffer));
+  FileOpens();
+  DirectoryListing();
+  // Without and with the blocks erased by the background task
+  WriteLatency("Write latency");
+  while (fs.PreErase()) {
+  }
+  WriteLatency("Write latency, pre-erased");
+  HistoryDay();
+  ReportWear();
+
+  fs.FileDelete(settingsPath);
+  fs.FileDelete(resourcePath);
+  fs.FileDelete(directory);
+}
+
+void FSBenchmark::SettingsSaves() {
+  const auto before = fs.GetStatistics();
+  const TickType_t start = xTaskGetTickCount();
+  for (size_t i = 0; i < nbSettingsSaves; i++) {
+    lfs_file_t file;
+    if (fs.FileOpen(&file, settingsPath, LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
+      return;
+    }
+    buffer[0] = i;
+    fs.FileWrite(&file, buffer, settingsSize);
+    fs.FileClose(&file);
+  }
+  Report("Settings saves", before, start);
+}
+
+void FSBenchmark::SettingsJournal() {
+  // Same changes as SettingsSaves(), journaled like Settings does: a 4 bytes record in a custom attribute
+  const auto before = fs.GetStatistics();
+  const TickType_t start = xTaskGetTickCount();
+  for (size_t i = 0; i < nbSettingsSaves; i++) {
+    const uint8_t record[] = {0, 2, static_cast<uint8_t>(i), 0};
+    fs.SetAttribute(settingsPath, 0x20 + (i % 16), record, sizeof(record));
+  }
+  Report("Settings journal", before, start);
+  for (uint8_t i = 0; i < 16; i++) {
+    fs.RemoveAttribute(settingsPath, 0x20 + i);
+  }
+}
+
+void FSBenchmark::ResourceUpload() {
+  const auto before = fs.GetStatistics();
+  const TickType_t start = xTaskGetTickCount();
+  lfs_file_t file;
+  if (fs.FileOpen(&file, resourcePath, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) != LFS_ERR_OK) {
+    return;
+  }
+  for (size_t written = 0; written < resourceSize; written += uploadChunkSize) {
+    const size_t size = std::min(uploadChunkSize, resourceSize - written);
+    buffer[0] = written;
+    fs.FileWrite(&file, buffer, size);
+  }
+  fs.FileClose(&file);
+  Report("Resource upload", before, start, resourceSize);
+}
+
+void FSBenchmark::ResourceReads(const char* name, uint32_t readSize) {
+  const auto before = fs.GetStatistics();
+  const TickType_t start = xTaskGetTickCount();
+  lfs_file_t file;
+  if (fs.FileOpen(&file, resourcePath, LFS_O_RDONLY) != LFS_ERR_OK) {
+    return;
+  }
+  uint32_t total = 0;
+  int res;
+  while ((res = fs.FileRead(&file, buffer, readSize)) > 0) {
+    total += res;
+  }
+  fs.FileClose(&file);
+  Report(name, before, start, total);
+}
+
+void FSBenchmark::FileOpens() {
+  const auto before = fs.GetStatistics();
+  const TickType_t start = xTaskGetTickCount();
+  for (size_t i = 0; i < nbFileOpens; i++) {
+    lfs_file_t file;
+    if (fs.FileOpen(&file, resourcePath, LFS_O_RDONLY) != LFS_ERR_OK) {
+      return;
+    }
+    fs.FileClose(&file);
+  }
+  Report("File opens", before, start);
+}
+
+void FSBenchmark::WriteLatency(const char* name) {
+  const auto before = fs.GetStatistics();
+  const TickType_t start = xTaskGetTickCount();
+  for (size_t i = 0; i < latencies.size(); i++) {
+    const Utility::ElapsedTime latency;
+    lfs_file_t file;
+    if (fs.FileOpen(&file, settingsPath, LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
+      return;
+    }
+    buffer[0] = i;
+    fs.FileWrite(&file, buffer, settingsSize);
+    fs.FileClose(&file);
+    latencies[i] = latency.Microseconds();
+  }
+  Report(name, before, start);
+
+  std::sort(latencies.begin(), latencies.end());
+  NRF_LOG_INFO("[FSBenchmark]   p50 %lu us, p90 %lu us, p99 %lu us, max %lu us",
+               latencies[latencies.size() / 2],
+               latencies[(latencies.size() * 90) / 100],
+               latencies[(latencies.size() * 99) / 100],
+               latencies.back());
+  NRF_LOG_INFO("[FSBenchmark]   %lu erases skipped, %d blocks still pre-erased",
+               fs.GetStatistics().erasesSkipped - before.erasesSkipped,
+               static_cast<int>(fs.PreErasedBlocks()));
+}
+
+void FSBenchmark::HistoryDay() {
+  // Static to keep its buffers off the SystemTask stack
+  static TimeSeries history(fs, historyDirectory);
+  history.Init();
+
+  const auto before = fs.GetStatistics();
+  const TickType_t start = xTaskGetTickCount();
+  const Utility::ElapsedTime appendTime;
+  uint32_t time = 1640995200;
+  for (size_t i = 0; i < nbHistoryIntervals; i++) {
+    history.Append(TimeSeries::Metrics::Steps, time, (i % 6) * 150);
+    history.Append(TimeSeries::Metrics::HeartRate, time, 60 + (i % 20));
+    history.Append(TimeSeries::Metrics::BatteryVoltage, time, 4100 - i);
+    time += historyInterval;
+  }
+  history.Flush();
+  uint32_t duration = appendTime.Microseconds();
+  const uint32_t nbRecords = nbHistoryIntervals * TimeSeries::nbMetrics;
+  Report("History, one day", before, start);
+  NRF_LOG_INFO("[FSBenchmark]   %lu records appended/s, %lu B of records, %lu B programmed per day",
+               (nbRecords * 1000) / std::max<uint32_t>(duration / 1000, 1),
+               history.GetStatistics().bytesWritten,
+               fs.GetStatistics().bytesProgrammed - before.bytesProgrammed);
+
+  const Utility::ElapsedTime readTime;
+  uint32_t nbRead = 0;
+  for (size_t i = 0; i < TimeSeries::nbMetrics; i++) {
+    nbRead += history.Read(
+      static_cast<TimeSeries::Metrics>(i),
+      0,
+      UINT32_MAX,
+      [](const TimeSeries::Record&, void*) {
+        return true;
+      },
+      nullptr);
+  }
+  duration = readTime.Microseconds();
+  NRF_LOG_INFO("[FSBenchmark]   %lu records read/s", (nbRead * 1000) / std::max<uint32_t>(duration / 1000, 1));
+
+  history.Clear();
+  fs.FileDelete(historyDirectory);
+}
+
+void FSBenchmark::DirectoryListing() {
+  const auto before = fs.GetStatistics();
+  const TickType_t start = xTaskGetTickCount();
+  static constexpr const char* directories[] = {"/", "/fonts", "/images", directory};
+  for (const char* path : directories) {
+    lfs_dir_t dir;
+    if (fs.DirOpen(path, &dir) != LFS_ERR_OK) {
+      continue;
+    }
+    while (fs.DirRead(&dir, &info) > 0) {
+    }
+    fs.DirClose(&dir);
+  }
+  Report("Directory listing", before, start);
+}
+
+void FSBenchmark::Report(const char* name, const FS::Statistics& before, TickType_t startTime, uint32_t bytes) {
+  const auto& after = fs.GetStatistics();
+  const uint32_t duration = ((xTaskGetTickCount() - startTime) * 1000) / configTICK_RATE_HZ;
+  if (bytes > 0 && duration > 0) {
+    NRF_LOG_INFO("[FSBenchmark] %s: %lu ms, %lu B/s", name, duration, (bytes * 1000) / duration);
+  } else {
+    NRF_LOG_INFO("[FSBenchmark] %s: %lu ms", name, duration);
+  }
+  NRF_LOG_INFO("[FSBenchmark]   %lu reads (%lu B, %lu ms)",
+               after.reads - before.reads,
+               after.bytesRead - before.bytesRead,
+               (after.readTime - before.readTime) / 1000);
+  NRF_LOG_INFO("[FSBenchmark]   %lu programs (%lu B, %lu ms)",
+               after.programs - before.programs,
+               after.bytesProgrammed - before.bytesProgrammed,
+               (after.programTime - before.programTime) / 1000);
+  NRF_LOG_INFO("[FSBenchmark]   %lu erases, %lu ms waiting for programs and erases to complete",
+               after.erases - before.erases,
+               (after.flashWaitTime - before.flashWaitTime) / 1000);
+}
+
+void FSBenchmark::ReportWear() {
+#ifdef FS_BENCHMARK
+  uint16_t maxErases = 0;
+  uint32_t erasedBlocks = 0;
+  for (auto count : fs.GetEraseCounts()) {
+    maxErases = std::max(maxErases, count);
+    erasedBlocks += (count > 0) ? 1 : 0;
+  }
+  NRF_LOG_INFO("[FSBenchmark] Wear: %lu blocks erased, at most %d times", erasedBlocks, maxErases);
+#endif
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <FreeRTOS.h>
+#include "components/fs/FS.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    // Storage workloads run on the watch (FS_BENCHMARK builds) to measure the flash traffic of littlefs.
+    // Each workload logs its duration and the reads, programs and erases it caused. The files are created in
+    // /.bench and removed afterwards. Run it once per littlefs profile (LITTLEFS_PROFILE) to compare them.
+    class FSBenchmark {
+    public:
+      explicit FSBenchmark(FS& fs);
+      void Run();
+
+    private:
+      void SettingsSaves();
+      void SettingsJournal();
+      void ResourceUpload();
+      void ResourceReads(const char* name, uint32_t readSize);
+      void FileOpens();
+      void WriteLatency(const char* name);
+      void HistoryDay();
+      void DirectoryListing();
+      void Report(const char* name, const FS::Statistics& before, TickType_t startTime, uint32_t bytes = 0);
+      void ReportWear();
+
+      static constexpr const char* directory = "/.bench";
+      static constexpr const char* settingsPath = "/.bench/settings.dat";
+      static constexpr const char* resourcePath = "/.bench/resource.bin";
+      static constexpr size_t settingsSize = 160;
+      static constexpr size_t nbSettingsSaves = 20;
+      static constexpr size_t resourceSize = 16 * 1024;
+      // Payload of an FSService write request with the default MTU
+      static constexpr size_t uploadChunkSize = 244;
+      static constexpr size_t nbFileOpens = 20;
+      static constexpr const char* historyDirectory = "/.bench/hist";
+      // One day of history recorded every 10 minutes
+      static constexpr uint32_t historyInterval = 10 * 60;
+      static constexpr size_t nbHistoryIntervals = 24 * 6;
+
+      FS& fs;
+    };
+  }
+}
@@ -0,0 +1,159 @@
+#include "components/fs/FileReadCache.h"
+#include <algorithm>
+#include <cstring>
+#include "components/fs/FS.h"
+
+using namespace Pinetime::Controllers;
+
+FileReadCache::FileReadCache(FS& fs) : fs {fs} {
+}
+
+int FileReadCache::Open(File& file, const char* path) {
+  int res = fs.FileOpen(&file.file, path, LFS_O_RDONLY);
+  if (res < 0) {
+    return res;
+  }
+
+  int size = fs.FileSize(&file.file);
+  if (size < 0) {
+    fs.FileClose(&file.file);
+    return size;
+  }
+
+  file.position = 0;
+  file.lfsPosition = 0;
+  file.size = size;
+  file.id = nextFileId++;
+  if (nextFileId == 0) {
+    nextFileId = 1;
+  }
+  file.lastLoadedBlock = -1;
+  return 0;
+}
+
+int FileReadCache::Close(File& file) {
+  for (auto& block : blocks) {
+    if (block.fileId == file.id) {
+      block.fileId = 0;
+    }
+  }
+  return fs.FileClose(&file.file);
+}
+
+void FileReadCache::Seek(File& file, uint32_t position) {
+  file.position = position;
+}
+
+int FileReadCache::Read(File& file, uint8_t* buffer, uint32_t size) {
+  if (file.position >= file.size) {
+    return 0;
+  }
+
+  uint32_t remaining = std::min(size, file.size - file.position);
+  uint32_t total = 0;
+  while (remaining > 0) {
+    const uint32_t index = file.position / blockSize;
+    const uint32_t offset = file.position % blockSize;
+
+    Block* block = Find(file, index);
+    if (block != nullptr) {
+      statistics.hits++;
+    } else if (offset == 0 && remaining >= blockSize) {
+      // Large aligned reads (glyph bitmaps, whole images) go straight to the caller's buffer
+      const uint32_t length = remaining - (remaining % blockSize);
+      int res = ReadFromFs(file, file.position, buffer + total, length);
+      if (res < 0) {
+        return res;
+      }
+      statistics.directReads++;
+      file.lastLoadedBlock = (file.position + length) / blockSize - 1;
+      file.position += length;
+      total += length;
+      remaining -= length;
+      continue;
+    } else {
+      statistics.misses++;
+      block = Load(file, index);
+      if (block == nullptr) {
+        return LFS_ERR_IO;
+      }
+    }
+
+    block->lastUse = ++useCounter;
+    const uint32_t length = std::min<uint32_t>(remaining, block->length - offset);
+    if (length == 0) {
+      break;
+    }
+    std::memcpy(buffer + total, block->data.data() + offset, length);
+    file.position += length;
+    total += length;
+    remaining -= length;
+  }
+  return total;
+}
+
+FileReadCache::Block* FileReadCache::Find(const File& file, uint32_t index) {
+  for (auto& block : blocks) {
+    if (block.fileId == file.id && block.index == index) {
+      return &block;
+    }
+  }
+  return nullptr;
+}
+
+FileReadCache::Block* FileReadCache::Load(File& file, uint32_t index) {
+  const bool sequential = static_cast<int32_t>(index) == file.lastLoadedBlock + 1;
+  const uint32_t nbFileBlocks = (file.size + blockSize - 1) / blockSize;
+  Block* loaded = nullptr;
+
+  // The littlefs file is already positioned after the first block, so reading ahead does not cost a seek
+  const uint32_t count = (sequential && index + 1 < nbFileBlocks && Find(file, index + 1) == nullptr) ? 2 : 1;
+  for (uint32_t i = 0; i < count; i++) {
+    Block& block = Victim();
+    const uint32_t position = (index + i) * blockSize;
+    int res = ReadFromFs(file, position, block.data.data(), std::min<uint32_t>(blockSize, file.size - position));
+    if (res < 0) {
+      block.fileId = 0;
+      return loaded;
+    }
+    block.fileId = file.id;
+    block.index = index + i;
+    block.length = res;
+    block.lastUse = ++useCounter;
+    file.lastLoadedBlock = index + i;
+    if (i == 0) {
+      loaded = &block;
+    } else {
+      statistics.readAheads++;
+    }
+  }
+  return loaded;
+}
+
+FileReadCache::Block& FileReadCache::Victim() {
+  Block* victim = &blocks[0];
+  for (auto& block : blocks) {
+    if (block.fileId == 0) {
+      return block;
+    }
+    if (block.lastUse < victim->lastUse) {
+      victim = &block;
+    }
+  }
+  return *victim;
+}
+
+int FileReadCache::ReadFromFs(File& file, uint32_t position, uint8_t* buffer, uint32_t size) {
+  if (file.lfsPosition != position) {
+    int res = fs.FileSeek(&file.file, position);
+    if (res < 0) {
+      return res;
+    }
+  }
+  int res = fs.FileRead(&file.file, buffer, size);
+  if (res < 0) {
+    return res;
+  }
+  file.lfsPosition = position + res;
+  return res;
+}
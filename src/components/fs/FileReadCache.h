@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <littlefs/lfs.h>
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+
+    // Read-only block cache in front of littlefs, used by the LVGL file system bridge.
+    // LVGL reads fonts and images in small pieces; they are served from a few aligned blocks,
+    // and the next block is read ahead when a file is read sequentially.
+    class FileReadCache {
+    public:
+      // 4 blocks of 512 B, plus 12 B of bookkeeping each: 2096 B of static RAM
+      static constexpr size_t blockSize = 512;
+      static constexpr size_t nbBlocks = 4;
+
+      struct File {
+        lfs_file_t file;
+        uint32_t position;    // position seen by the caller
+        uint32_t lfsPosition; // position of the littlefs file, a read there does not need a seek
+        uint32_t size;
+        uint16_t id;
+        int32_t lastLoadedBlock;
+      };
+
+      struct Statistics {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t readAheads = 0;
+        uint32_t directReads = 0;
+      };
+
+      explicit FileReadCache(FS& fs);
+
+      int Open(File& file, const char* path);
+      int Close(File& file);
+      int Read(File& file, uint8_t* buffer, uint32_t size);
+      void Seek(File& file, uint32_t position);
+
+      const Statistics& GetStatistics() const {
+        return statistics;
+      }
+
+    private:
+      struct Block {
+        uint16_t fileId = 0; // 0: unused
+        uint16_t length = 0;
+        uint32_t index = 0;
+        uint32_t lastUse = 0;
+        std::array<uint8_t, blockSize> data;
+      };
+
+      Block* Find(const File& file, uint32_t index);
+      Block* Load(File& file, uint32_t index);
+      Block& Victim();
+      int ReadFromFs(File& file, uint32_t position, uint8_t* buffer, uint32_t size);
+
+      FS& fs;
+      std::array<Block, nbBlocks> blocks;
+      uint32_t useCounter = 0;
+      uint16_t nextFileId = 1;
+      Statistics statistics;
+    };
+  }
+}
@@ -0,0 +1,403 @@
+#include "components/fs/TimeSeries.h"
+#include <algorithm>
+#include <cstdio>
+#include <nrf_log.h>
+#include "components/fs/FS.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  lfs_info info;
+}
+
+TimeSeries::TimeSeries(FS& fs, const char* directory) : fs {fs}, directory {directory} {
+}
+
+void TimeSeries::Init() {
+  fs.DirCreate(directory);
+
+  lfs_dir_t dir;
+  if (fs.DirOpen(directory, &dir) != LFS_ERR_OK) {
+    return;
+  }
+  while (fs.DirRead(&dir, &info) > 0) {
+    // Segments are named m<metric>_<sequence number>
+    if (info.type != LFS_TYPE_REG || info.name[0] != 'm' || info.name[2] != '_') {
+      continue;
+    }
+    const uint8_t metric = info.name[1] - '0';
+    if (metric >= nbMetrics || info.name[3] == '\0') {
+      continue;
+    }
+    uint32_t segment = 0;
+    bool valid = true;
+    for (const char* c = &info.name[3]; *c != '\0'; c++) {
+      if (*c < '0' || *c > '9') {
+        valid = false;
+        break;
+      }
+      segment = segment * 10 + (*c - '0');
+    }
+    if (!valid || segment > UINT16_MAX) {
+      continue;
+    }
+
+    auto& s = series[metric];
+    if (!s.hasSegment || segment < s.firstSegment) {
+      s.firstSegment = segment;
+    }
+    if (!s.hasSegment || segment > s.lastSegment) {
+      s.lastSegment = segment;
+    }
+    s.hasSegment = true;
+    s.storedBytes += info.size;
+  }
+  fs.DirClose(&dir);
+
+  for (size_t i = 0; i < nbMetrics; i++) {
+    if (series[i].hasSegment) {
+      RestoreLastRecord(static_cast<Metrics>(i));
+    }
+  }
+}
+
+void TimeSeries::Append(Metrics metric, uint32_t time, int32_t value) {
+  auto& s = series[static_cast<uint8_t>(metric)];
+  statistics.appends++;
+
+  // Times only increase within a segment, a new one is started if the clock went back
+  if (!s.hasSegment || (s.hasPrevious && time < s.previousTime) || (s.segmentSize + s.nbPending + maxRecordSize > maxSegmentSize)) {
+    StartSegment(metric);
+  }
+  if (s.nbPending + maxRecordSize > pendingSize) {
+    FlushSeries(metric);
+  }
+  Encode(s, time, value);
+}
+
+void TimeSeries::Flush() {
+  for (size_t i = 0; i < nbMetrics; i++) {
+    FlushSeries(static_cast<Metrics>(i));
+  }
+}
+
+int TimeSeries::Read(Metrics metric, uint32_t from, uint32_t to, RecordConsumer consumer, void* context) {
+  FlushSeries(metric);
+
+  const auto& s = series[static_cast<uint8_t>(metric)];
+  if (!s.hasSegment) {
+    return 0;
+  }
+
+  int count = 0;
+  for (uint32_t segment = s.firstSegment; segment <= s.lastSegment; segment++) {
+    char path[32];
+    SegmentPath(path, metric, segment);
+    lfs_file_t file;
+    if (fs.FileOpen(&file, path, LFS_O_RDONLY) != LFS_ERR_OK) {
+      continue;
+    }
+
+    SegmentReader reader(fs, file);
+    uint8_t flags;
+    if (!reader.ReadHeader(metric, flags)) {
+      fs.FileClose(&file);
+      continue;
+    }
+
+    Record record {};
+    bool hasPrevious = false;
+    bool stop = false;
+    while (reader.ReadRecord(record, hasPrevious)) {
+      if (record.time >= to) {
+        break;
+      }
+      if (record.time < from) {
+        continue;
+      }
+      count++;
+      if (!consumer(record, context)) {
+        stop = true;
+        break;
+      }
+    }
+    fs.FileClose(&file);
+    if (stop) {
+      break;
+    }
+  }
+  return count;
+}
+
+void TimeSeries::Clear() {
+  for (size_t i = 0; i < nbMetrics; i++) {
+    auto& s = series[i];
+    if (s.hasSegment) {
+      for (uint32_t segment = s.firstSegment; segment <= s.lastSegment; segment++) {
+        char path[32];
+        SegmentPath(path, static_cast<Metrics>(i), segment);
+        fs.FileDelete(path);
+      }
+    }
+    s.hasSegment = false;
+    s.hasPrevious = false;
+    s.firstSegment = 0;
+    s.lastSegment = 0;
+    s.segmentSize = 0;
+    s.storedBytes = 0;
+    s.nbPending = 0;
+  }
+}
+
+void TimeSeries::FlushSeries(Metrics metric) {
+  auto& s = series[static_cast<uint8_t>(metric)];
+  if (s.nbPending == 0) {
+    return;
+  }
+
+  char path[32];
+  SegmentPath(path, metric, s.lastSegment);
+  lfs_file_t file;
+  if (fs.FileOpen(&file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND) != LFS_ERR_OK) {
+    NRF_LOG_WARNING("[TimeSeries] Could not open %s, %d bytes lost", path, s.nbPending);
+    s.nbPending = 0;
+    return;
+  }
+  const int written = fs.FileWrite(&file, s.pending.data(), s.nbPending);
+  fs.FileClose(&file);
+  if (written > 0) {
+    s.segmentSize += written;
+    s.storedBytes += written;
+    statistics.bytesWritten += written;
+  }
+  statistics.flushes++;
+  s.nbPending = 0;
+
+  Trim(metric);
+}
+
+void TimeSeries::StartSegment(Metrics metric) {
+  auto& s = series[static_cast<uint8_t>(metric)];
+  FlushSeries(metric);
+
+  if (s.hasSegment) {
+    s.lastSegment++;
+  } else {
+    s.firstSegment = s.lastSegment;
+    s.hasSegment = true;
+  }
+  s.segmentSize = 0;
+  s.hasPrevious = false;
+  s.pending[0] = magic0;
+  s.pending[1] = magic1;
+  s.pending[2] = static_cast<uint8_t>(metric);
+  s.pending[3] = 0;
+  s.nbPending = headerSize;
+}
+
+void TimeSeries::Trim(Metrics metric) {
+  auto& s = series[static_cast<uint8_t>(metric)];
+  // The segment being appended to is never compacted nor deleted
+  while (s.storedBytes > budgetBytes && s.firstSegment != s.lastSegment) {
+    uint32_t freed = 0;
+    if (Compact(metric, s.firstSegment, freed)) {
+      s.storedBytes -= freed;
+      statistics.compactions++;
+      continue;
+    }
+
+    char path[32];
+    SegmentPath(path, metric, s.firstSegment);
+    if (fs.Stat(path, &info) == LFS_ERR_OK) {
+      s.storedBytes -= std::min<uint32_t>(info.size, s.storedBytes);
+    }
+    fs.FileDelete(path);
+    s.firstSegment++;
+    statistics.deletions++;
+  }
+}
+
+bool TimeSeries::Compact(Metrics metric, uint16_t segment, uint32_t& freed) {
+  char path[32];
+  char tempPath[34];
+  SegmentPath(path, metric, segment);
+  snprintf(tempPath, sizeof(tempPath), "%s~", path);
+
+  lfs_file_t source;
+  if (fs.FileOpen(&source, path, LFS_O_RDONLY) != LFS_ERR_OK) {
+    return false;
+  }
+  SegmentReader reader(fs, source);
+  uint8_t flags;
+  if (!reader.ReadHeader(metric, flags) || (flags & compactedFlag) != 0) {
+    fs.FileClose(&source);
+    return false;
+  }
+  const uint32_t sourceSize = fs.FileSize(&source);
+
+  lfs_file_t destination;
+  if (fs.FileOpen(&destination, tempPath, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) != LFS_ERR_OK) {
+    fs.FileClose(&source);
+    return false;
+  }
+
+  // Records are aggregated per hour and written through a small buffer: steps are summed, other metrics averaged.
+  // Static to keep its buffer off the SystemTask stack
+  static Series output;
+  output = {};
+  output.pending[0] = magic0;
+  output.pending[1] = magic1;
+  output.pending[2] = static_cast<uint8_t>(metric);
+  output.pending[3] = compactedFlag;
+  output.nbPending = headerSize;
+  uint32_t destinationSize = 0;
+  auto write = [&]() {
+    const int res = fs.FileWrite(&destination, output.pending.data(), output.nbPending);
+    if (res > 0) {
+      destinationSize += res;
+    }
+    output.nbPending = 0;
+  };
+  auto emit = [&](uint32_t time, int32_t sum, uint32_t count) {
+    if (output.nbPending + maxRecordSize > pendingSize) {
+      write();
+    }
+    Encode(output, time, (metric == Metrics::Steps) ? sum : sum / static_cast<int32_t>(count));
+  };
+
+  Record record {};
+  bool hasPrevious = false;
+  uint32_t bucket = 0;
+  int32_t sum = 0;
+  uint32_t count = 0;
+  while (reader.ReadRecord(record, hasPrevious)) {
+    const uint32_t recordBucket = record.time - (record.time % compactedInterval);
+    if (count > 0 && recordBucket != bucket) {
+      emit(bucket, sum, count);
+      sum = 0;
+      count = 0;
+    }
+    bucket = recordBucket;
+    sum += record.value;
+    count++;
+  }
+  if (count > 0) {
+    emit(bucket, sum, count);
+  }
+  write();
+  fs.FileClose(&destination);
+  fs.FileClose(&source);
+
+  if (fs.Rename(tempPath, path) != LFS_ERR_OK) {
+    fs.FileDelete(tempPath);
+    return false;
+  }
+  freed = (sourceSize > destinationSize) ? sourceSize - destinationSize : 0;
+  return true;
+}
+
+void TimeSeries::RestoreLastRecord(Metrics metric) {
+  auto& s = series[static_cast<uint8_t>(metric)];
+  char path[32];
+  SegmentPath(path, metric, s.lastSegment);
+
+  // Until the last record is known, appends go to a new segment
+  s.segmentSize = maxSegmentSize;
+  lfs_file_t file;
+  if (fs.FileOpen(&file, path, LFS_O_RDONLY) != LFS_ERR_OK) {
+    return;
+  }
+  SegmentReader reader(fs, file);
+  uint8_t flags;
+  if (reader.ReadHeader(metric, flags) && (flags & compactedFlag) == 0) {
+    Record record {};
+    bool hasPrevious = false;
+    while (reader.ReadRecord(record, hasPrevious)) {
+    }
+    s.hasPrevious = hasPrevious;
+    s.previousTime = record.time;
+    s.previousValue = record.value;
+    s.segmentSize = fs.FileSize(&file);
+  }
+  fs.FileClose(&file);
+}
+
+void TimeSeries::SegmentPath(char* path, Metrics metric, uint16_t segment) const {
+  snprintf(path, 32, "%s/m%u_%05u", directory, static_cast<unsigned>(metric), segment);
+}
+
+void TimeSeries::Encode(Series& s, uint32_t time, int32_t value) {
+  const uint32_t timeDelta = s.hasPrevious ? time - s.previousTime : time;
+  const int32_t valueDelta = s.hasPrevious ? value - s.previousValue : value;
+  s.nbPending += EncodeVarint(&s.pending[s.nbPending], timeDelta);
+  s.nbPending += EncodeVarint(&s.pending[s.nbPending], ZigZag(valueDelta));
+  s.hasPrevious = true;
+  s.previousTime = time;
+  s.previousValue = value;
+}
+
+size_t TimeSeries::EncodeVarint(uint8_t* buffer, uint32_t value) {
+  size_t size = 0;
+  while (value >= 0x80) {
+    buffer[size++] = static_cast<uint8_t>(value) | 0x80;
+    value >>= 7;
+  }
+  buffer[size++] = static_cast<uint8_t>(value);
+  return size;
+}
+
+bool TimeSeries::SegmentReader::ReadByte(uint8_t& byte) {
+  if (position == length) {
+    const int res = fs.FileRead(&file, buffer.data(), buffer.size());
+    if (res <= 0) {
+      return false;
+    }
+    length = res;
+    position = 0;
+  }
+  byte = buffer[position++];
+  return true;
+}
+
+bool TimeSeries::SegmentReader::ReadHeader(Metrics metric, uint8_t& flags) {
+  uint8_t header[headerSize];
+  for (auto& byte : header) {
+    if (!ReadByte(byte)) {
+      return false;
+    }
+  }
+  flags = header[3];
+  return header[0] == magic0 && header[1] == magic1 && header[2] == static_cast<uint8_t>(metric);
+}
+
+bool TimeSeries::SegmentReader::ReadVarint(uint32_t& value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    uint8_t byte;
+    if (!ReadByte(byte)) {
+      return false;
+    }
+    value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TimeSeries::SegmentReader::ReadRecord(Record& previous, bool& hasPrevious) {
+  uint32_t timeDelta;
+  uint32_t valueDelta;
+  if (!ReadVarint(timeDelta) || !ReadVarint(valueDelta)) {
+    return false;
+  }
+  if (hasPrevious) {
+    previous.time += timeDelta;
+    previous.value += UnZigZag(valueDelta);
+  } else {
+    previous.time = timeDelta;
+    previous.value = UnZigZag(valueDelta);
+  }
+  hasPrevious = true;
+  return true;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <littlefs/lfs.h>
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+
+    // Append-only history of a few metrics (steps per interval, heart rate, battery voltage) stored in littlefs.
+    // Each metric is a sequence of segment files of at most half a block. A segment starts with a 4 bytes header and
+    // contains (time, value) records encoded as varints relative to the previous record of the segment, usually
+    // 3 to 4 bytes per record. Records are batched in RAM and appended to the last segment when the batch is full
+    // or when Flush() is called. littlefs appends to a file by copying its last, partially written block to a new
+    // one: the batches and the segment size bound the bytes programmed for each append. When a metric uses more than
+    // its budget, its oldest segment is downsampled to one record per hour, or deleted if it was already downsampled.
+    class TimeSeries {
+    public:
+      enum class Metrics : uint8_t { Steps, HeartRate, BatteryVoltage };
+      static constexpr size_t nbMetrics = 3;
+
+      struct Record {
+        uint32_t time; // seconds since epoch, UTC
+        int32_t value;
+      };
+
+      // Called for each record of a range, return false to stop the read
+      using RecordConsumer = bool (*)(const Record& record, void* context);
+
+      struct Statistics {
+        uint32_t appends = 0;
+        uint32_t flushes = 0;
+        uint32_t bytesWritten = 0;
+        uint32_t compactions = 0;
+        uint32_t deletions = 0;
+      };
+
+      TimeSeries(FS& fs, const char* directory = "/hist");
+
+      void Init();
+      void Append(Metrics metric, uint32_t time, int32_t value);
+      void Flush();
+      // Reads the records of a metric with from <= time < to, oldest first
+      int Read(Metrics metric, uint32_t from, uint32_t to, RecordConsumer consumer, void* context);
+      // Deletes the history of all the metrics
+      void Clear();
+
+      uint32_t StoredBytes(Metrics metric) const {
+        return series[static_cast<uint8_t>(metric)].storedBytes;
+      }
+
+      const Statistics& GetStatistics() const {
+        return statistics;
+      }
+
+    private:
+      static constexpr size_t headerSize = 4;
+      static constexpr uint8_t magic0 = 'T';
+      static constexpr uint8_t magic1 = 'S';
+      static constexpr uint8_t compactedFlag = 0x80;
+      // A record is at most two 5 bytes varints
+      static constexpr size_t maxRecordSize = 10;
+      static constexpr size_t maxSegmentSize = 2048;
+      // About 50 records, a few appends per metric and per day at one record every 10 minutes
+      static constexpr size_t pendingSize = 192;
+      static constexpr uint32_t budgetBytes = 16 * 1024;
+      static constexpr uint32_t compactedInterval = 60 * 60;
+
+      struct Series {
+        uint16_t firstSegment = 0;
+        uint16_t lastSegment = 0;
+        bool hasSegment = false;
+        // The last record, deltas of the next one are relative to it
+        bool hasPrevious = false;
+        uint32_t previousTime = 0;
+        int32_t previousValue = 0;
+        uint32_t segmentSize = 0;
+        uint32_t storedBytes = 0;
+        uint8_t nbPending = 0;
+        std::array<uint8_t, pendingSize> pending;
+      };
+
+      // Buffered sequential reads of a segment
+      class SegmentReader {
+      public:
+        SegmentReader(FS& fs, lfs_file_t& file) : fs {fs}, file {file} {
+        }
+
+        bool ReadHeader(Metrics metric, uint8_t& flags);
+        bool ReadByte(uint8_t& byte);
+        bool ReadVarint(uint32_t& value);
+        bool ReadRecord(Record& previous, bool& hasPrevious);
+
+      private:
+        FS& fs;
+        lfs_file_t& file;
+        std::array<uint8_t, 32> buffer;
+        uint8_t position = 0;
+        uint8_t length = 0;
+      };
+
+      void FlushSeries(Metrics metric);
+      void StartSegment(Metrics metric);
+      void Trim(Metrics metric);
+      bool Compact(Metrics metric, uint16_t segment, uint32_t& freed);
+      void RestoreLastRecord(Metrics metric);
+      void SegmentPath(char* path, Metrics metric, uint16_t segment) const;
+      void Encode(Series& s, uint32_t time, int32_t value);
+
+      static size_t EncodeVarint(uint8_t* buffer, uint32_t value);
+      static uint32_t ZigZag(int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+      }
+      static int32_t UnZigZag(uint32_t value) {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+      }
+
+      FS& fs;
+      const char* directory;
+      std::array<Series, nbMetrics> series;
+      Statistics statistics;
+    };
+  }
+}
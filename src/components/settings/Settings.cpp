@@ -1,6 +1,8 @@
 #include "components/settings/Settings.h"
 #include <cstdlib>
 #include <cstring>
+#include <nrf_log.h>
+#include "utility/ElapsedTime.h"
 
 using namespace Pinetime::Controllers;
 
@@ -23,25 +25,117 @@ void Settings::SaveSettings() {
 }
 
 void Settings::LoadSettingsFromFile() {
+  const Utility::ElapsedTime loadTime;
   SettingsData bufferSettings;
   lfs_file_t settingsFile;
 
-  if (fs.FileOpen(&settingsFile, "/settings.dat", LFS_O_RDONLY) != LFS_ERR_OK) {
+  std::memcpy(&savedSettings, &settings, sizeof(SettingsData));
+  if (fs.FileOpen(&settingsFile, settingsPath, LFS_O_RDONLY) != LFS_ERR_OK) {
     return;
   }
   fs.FileRead(&settingsFile, reinterpret_cast<uint8_t*>(&bufferSettings), sizeof(settings));
   fs.FileClose(&settingsFile);
-  if (bufferSettings.version == settingsVersion) {
-    settings = bufferSettings;
+  snapshotExists = true;
+  if (bufferSettings.version != settingsVersion) {
+    // Write a new snapshot and drop any journal on the next save
+    nbJournalRecords = maxJournalRecords;
+    return;
+  }
+
+  // Records are appended one after the other: the first missing one ends the journal, each lookup is a metadata read
+  uint8_t record[FS::maxAttributeSize];
+  for (uint8_t i = 0; i < maxJournalRecords; i++) {
+    const int size = fs.GetAttribute(settingsPath, journalAttribute + i, record, sizeof(record));
+    if (size <= 0) {
+      break;
+    }
+    ApplyJournalRecord(bufferSettings, record, size);
+    nbJournalRecords = i + 1;
   }
+  settings = bufferSettings;
+  std::memcpy(&savedSettings, &settings, sizeof(SettingsData));
+  NRF_LOG_INFO("[Settings] Loaded with %d journal records in %lu us", nbJournalRecords, loadTime.Microseconds());
 }
 
 void Settings::SaveSettingsToFile() {
+  if (snapshotExists && nbJournalRecords < maxJournalRecords && AppendJournalRecord()) {
+    return;
+  }
+  WriteSnapshot();
+}
+
+bool Settings::AppendJournalRecord() {
+  // A record is a list of [offset, length, bytes] runs of the settings that changed since they were saved
+  uint8_t record[FS::maxAttributeSize];
+  size_t size = 0;
+  const auto* current = reinterpret_cast<const uint8_t*>(&settings);
+  const auto* saved = reinterpret_cast<const uint8_t*>(&savedSettings);
+  size_t offset = 0;
+  while (offset < sizeof(SettingsData)) {
+    if (current[offset] == saved[offset]) {
+      offset++;
+      continue;
+    }
+
+    // Unchanged bytes shorter than a run header are included in the run
+    size_t lastChanged = offset;
+    for (size_t i = offset + 1; i < sizeof(SettingsData) && i - lastChanged <= 2; i++) {
+      if (current[i] != saved[i]) {
+        lastChanged = i;
+      }
+    }
+    const size_t length = lastChanged + 1 - offset;
+    if (size + 2 + length > sizeof(record)) {
+      return false;
+    }
+    record[size++] = offset;
+    record[size++] = length;
+    std::memcpy(&record[size], &current[offset], length);
+    size += length;
+    offset = lastChanged + 1;
+  }
+
+  if (size == 0) {
+    return true;
+  }
+  if (fs.SetAttribute(settingsPath, journalAttribute + nbJournalRecords, record, size) < 0) {
+    return false;
+  }
+  nbJournalRecords++;
+  std::memcpy(&savedSettings, &settings, sizeof(SettingsData));
+  NRF_LOG_INFO("[Settings] Journal record %d: %d B", nbJournalRecords, static_cast<int>(size));
+  return true;
+}
+
+void Settings::WriteSnapshot() {
   lfs_file_t settingsFile;
 
-  if (fs.FileOpen(&settingsFile, "/settings.dat", LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
+  // The new snapshot replaces the file with a rename, which also drops the journal attributes of the old one: a power
+  // loss leaves either the old snapshot and its journal or the new snapshot, never the new snapshot with old records
+  if (fs.FileOpen(&settingsFile, snapshotPath, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) != LFS_ERR_OK) {
     return;
   }
   fs.FileWrite(&settingsFile, reinterpret_cast<uint8_t*>(&settings), sizeof(settings));
-  fs.FileClose(&settingsFile);
+  if (fs.FileClose(&settingsFile) != LFS_ERR_OK || fs.Rename(snapshotPath, settingsPath) != LFS_ERR_OK) {
+    return;
+  }
+  snapshotExists = true;
+  nbJournalRecords = 0;
+  std::memcpy(&savedSettings, &settings, sizeof(SettingsData));
+  NRF_LOG_INFO("[Settings] Snapshot: %d B", static_cast<int>(sizeof(settings)));
+}
+
+void Settings::ApplyJournalRecord(SettingsData& data, const uint8_t* record, size_t size) {
+  auto* bytes = reinterpret_cast<uint8_t*>(&data);
+  size_t position = 0;
+  while (position + 2 <= size) {
+    const uint8_t offset = record[position];
+    const uint8_t length = record[position + 1];
+    position += 2;
+    if (position + length > size || offset + length > sizeof(SettingsData)) {
+      return;
+    }
+    std::memcpy(&bytes[offset], &record[position], length);
+    position += length;
+  }
 }
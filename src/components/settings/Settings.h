@@ -343,6 +343,19 @@ namespace Pinetime {
       SettingsData settings;
       bool settingsChanged = false;
 
+      // Changes are journaled as custom attributes of the snapshot file: each record is a small metadata commit
+      // instead of a rewrite of the file. The journal is folded into a new snapshot when it is full.
+      static constexpr const char* settingsPath = "/settings.dat";
+      // New snapshots are written here, then renamed over the settings file
+      static constexpr const char* snapshotPath = "/settings.tmp";
+      static constexpr uint8_t journalAttribute = 0x20;
+      static constexpr uint8_t maxJournalRecords = 16;
+      static_assert(sizeof(SettingsData) <= UINT8_MAX, "journal records use 8 bits offsets");
+      // Settings as they are stored in the file system
+      SettingsData savedSettings;
+      uint8_t nbJournalRecords = 0;
+      bool snapshotExists = false;
+
       uint8_t appMenu = 0;
       uint8_t settingsMenu = 0;
       uint8_t watchFacesMenu = 0;
@@ -353,6 +366,9 @@ namespace Pinetime {
 
       void LoadSettingsFromFile();
       void SaveSettingsToFile();
+      bool AppendJournalRecord();
+      void WriteSnapshot();
+      static void ApplyJournalRecord(SettingsData& data, const uint8_t* record, size_t size);
     };
   }
 }
@@ -7,6 +7,7 @@ namespace Pinetime {
 
   namespace Components {
     class LittleVgl;
+    class FontCache;
   }
 
   namespace Controllers {
@@ -51,6 +52,7 @@ namespace Pinetime {
       Pinetime::Components::LittleVgl& lvgl;
       Pinetime::Controllers::MusicService* musicService;
       Pinetime::Controllers::NavigationService* navigationService;
+      Pinetime::Components::FontCache& fontCache;
     };
   }
 }
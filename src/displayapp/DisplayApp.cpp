@@ -52,6 +52,7 @@
 #include "displayapp/screens/settings/SettingBluetooth.h"
 
 #include "libs/lv_conf.h"
+#include "utility/ElapsedTime.h"
 #include "UserApps.h"
 
 #include <algorithm>
@@ -85,7 +86,8 @@ DisplayApp::DisplayApp(Drivers::St7789& lcd,
                        Pinetime::Controllers::BrightnessController& brightnessController,
                        Pinetime::Controllers::TouchHandler& touchHandler,
                        Pinetime::Controllers::FS& filesystem,
-                       Pinetime::Drivers::SpiNorFlash& spiNorFlash)
+                       Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                       Pinetime::Controllers::FrameStatistics& frameStatistics)
   : lcd {lcd},
     touchPanel {touchPanel},
     batteryController {batteryController},
@@ -102,7 +104,8 @@ DisplayApp::DisplayApp(Drivers::St7789& lcd,
     touchHandler {touchHandler},
     filesystem {filesystem},
     spiNorFlash {spiNorFlash},
-    lvgl {lcd, filesystem},
+    frameStatistics {frameStatistics},
+    lvgl {lcd, filesystem, frameStatistics},
     timer(this, TimerCallback),
     controllers {batteryController,
                  bleController,
@@ -121,7 +124,8 @@ DisplayApp::DisplayApp(Drivers::St7789& lcd,
                  this,
                  lvgl,
                  nullptr,
-                 nullptr} {
+                 nullptr,
+                 fontCache} {
 }
 
 void DisplayApp::Start(System::BootErrors error) {
@@ -132,6 +136,7 @@ void DisplayApp::Start(System::BootErrors error) {
   if (pdPASS != xTaskCreate(DisplayApp::Process, "displayapp", 800, this, 0, &taskHandle)) {
     APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
   }
+  filesystem.RegisterClient(Controllers::FS::Clients::Display, taskHandle);
 }
 
 void DisplayApp::Process(void* instance) {
@@ -139,6 +144,10 @@ void DisplayApp::Process(void* instance) {
   NRF_LOG_INFO("displayapp task started!");
   app->Init();
 
+#ifdef LVGL_FRAME_BENCHMARK
+  app->RunFrameCostBenchmark();
+#endif
+
   if (app->bootError == System::BootErrors::TouchController) {
     app->LoadNewScreen(Apps::Error, DisplayApp::FullRefreshDirections::None);
   } else {
@@ -327,11 +336,17 @@ void DisplayApp::Refresh() {
         lvgl.ClearTouchState();
         if (msg == Messages::GoToAOD) {
           lcd.LowPowerOn();
+          // Render the watch face at a quarter of the pixels
+          if (currentScreen->SupportsPixelDoubling()) {
+            SetPixelDoubling(true);
+          }
           // Record idle entry time
           alwaysOnFrameCount = 0;
           alwaysOnStartTime = xTaskGetTickCount();
           PushMessageToSystemTask(Pinetime::System::Messages::OnDisplayTaskAOD);
           state = States::AOD;
+          ApplyColorDepth();
+          ApplyDrawBufferLines();
         } else {
           lcd.Sleep();
           PushMessageToSystemTask(Pinetime::System::Messages::OnDisplayTaskSleeping);
@@ -348,14 +363,26 @@ void DisplayApp::Refresh() {
         if (state == States::Running || systemTask->IsSleeping()) {
           break;
         }
-        if (state == States::AOD) {
-          lcd.LowPowerOff();
-        } else {
-          lcd.Wakeup();
+        {
+          // In AOD, the display is on and already up to date
+          const bool wasSleeping = state != States::AOD;
+          if (wasSleeping) {
+            lcd.Wakeup();
+          } else {
+            lcd.LowPowerOff();
+            if (lvgl.IsPixelDoubling()) {
+              SetPixelDoubling(false);
+            }
+          }
+          lv_disp_trig_activity(nullptr);
+          state = States::Running;
+          ApplyColorDepth();
+          ApplyDrawBufferLines();
+          if (wasSleeping) {
+            RefreshRetainedFrame();
+          }
         }
-        lv_disp_trig_activity(nullptr);
         ApplyBrightness();
-        state = States::Running;
         break;
       case Messages::UpdateBleConnection:
         // Only used for recovery firmware
@@ -477,6 +504,9 @@ void DisplayApp::Refresh() {
         LoadNewScreen(Apps::Clock, DisplayApp::FullRefreshDirections::None);
         motorController.RunForDuration(35);
         break;
+      case Messages::FilesChanged:
+        fontCache.Invalidate();
+        break;
     }
   }
 
@@ -512,6 +542,12 @@ void DisplayApp::LoadScreen(Apps app, DisplayApp::FullRefreshDirections directio
   motorController.StopRinging();
 
   currentScreen.reset(nullptr);
+  // The fonts released by the previous screen stay loaded only as long as they do not starve the next one
+  fontCache.Trim(fontCacheMinFreeHeap);
+  // Only the watch face is laid out for pixel doubling, other screens (notifications, timers...) need the full display
+  if (lvgl.IsPixelDoubling() && app != Apps::Clock) {
+    lvgl.SetPixelDoubling(false);
+  }
   SetFullRefresh(direction);
 
   switch (app) {
@@ -632,7 +668,8 @@ void DisplayApp::LoadScreen(Apps app, DisplayApp::FullRefreshDirections directio
                                                             watchdog,
                                                             motionController,
                                                             touchPanel,
-                                                            spiNorFlash);
+                                                            spiNorFlash,
+                                                            frameStatistics);
       break;
     case Apps::FlashLight:
       currentScreen = std::make_unique<Screens::FlashLight>(*systemTask, brightnessController);
@@ -650,6 +687,7 @@ void DisplayApp::LoadScreen(Apps app, DisplayApp::FullRefreshDirections directio
     }
   }
   currentApp = app;
+  ApplyColorDepth();
 }
 
 void DisplayApp::PushMessage(Messages msg) {
@@ -718,6 +756,120 @@ void DisplayApp::Register(Pinetime::Controllers::NavigationService* NavigationSe
   this->controllers.navigationService = NavigationService;
 }
 
+void DisplayApp::ApplyColorDepth() {
+  // Idle mode (AOD) only displays 8 colours, 12-bit pixels make no visible difference there
+  if (state == States::AOD || (currentScreen != nullptr && currentScreen->AllowReducedColorDepth())) {
+    lvgl.SetColorDepth(Components::LittleVgl::ColorDepths::Reduced);
+  } else {
+    lvgl.SetColorDepth(Components::LittleVgl::ColorDepths::Full);
+  }
+}
+
+void DisplayApp::RefreshRetainedFrame() {
+  // The display keeps its frame memory while sleeping: it already holds the last frame, only the parts
+  // that changed since (time, date...) are rendered and sent before the backlight turns on
+  TickType_t start = xTaskGetTickCount();
+  // Lets the screen update its widgets, then renders them right away
+  lv_task_handler();
+  lv_refr_now(nullptr);
+  lvgl.WaitForLastFlush();
+  NRF_LOG_INFO("[LCD] Retained frame updated in %d ms", (xTaskGetTickCount() - start) * 1000 / configTICK_RATE_HZ);
+}
+
+void DisplayApp::ApplyDrawBufferLines() {
+  lvgl.SetDrawBufferLines(state == States::AOD ? alwaysOnDrawBufferLines : runningDrawBufferLines);
+}
+
+void DisplayApp::SetPixelDoubling(bool enabled) {
+  // The watch face moves its objects for the new display size: recreating it would also free and allocate all its
+  // objects, and its refresh task, on every AOD entry and wake-up
+  const Utility::ElapsedTime switchTime;
+  lvgl.SetPixelDoubling(enabled);
+  currentScreen->SetLowResolution(enabled);
+  NRF_LOG_INFO("[LCD] Pixel doubling %s in %lu us", enabled ? "on" : "off", switchTime.Microseconds());
+}
+
+#ifdef LVGL_FRAME_BENCHMARK
+void DisplayApp::RunFrameCostBenchmark() {
+  lcd.LogPreTransactionHookCost();
+
+  // Renders a full frame of every watch face and app, halving the band height down to the minimum
+  for (uint8_t lines = Components::LittleVgl::MaxDrawBufferLines(); lines >= Components::LittleVgl::MinDrawBufferLines(); lines /= 2) {
+    lvgl.SetDrawBufferLines(lines);
+    for (const auto& watchFace : userWatchFaces) {
+      if (watchFace.isAvailable(controllers.filesystem)) {
+        currentScreen.reset(watchFace.create(controllers));
+        LogFrameCost("watch face", static_cast<uint8_t>(watchFace.watchFace), lines);
+        currentScreen.reset(nullptr);
+      }
+    }
+    for (const auto& userApp : userApps) {
+      if (userApp.isAvailable(controllers.filesystem)) {
+        currentScreen.reset(userApp.create(controllers));
+        LogFrameCost("app", static_cast<uint8_t>(userApp.app), lines);
+        currentScreen.reset(nullptr);
+      }
+    }
+  }
+  ApplyDrawBufferLines();
+}
+
+void DisplayApp::LogFrameCost(const char* kind, uint8_t id, uint8_t lines) {
+  lv_obj_invalidate(lv_scr_act());
+  lv_refr_now(nullptr);
+  const auto& stats = lvgl.GetLastFrameStats();
+  NRF_LOG_INFO("[Frame cost] %s %d - %d lines (%d B used of %d B allocated): %d ms, %d flushes, %d B sent",
+               kind,
+               id,
+               lines,
+               Components::LittleVgl::DrawBufferBytes(lines),
+               Components::LittleVgl::StaticDrawBufferBytes(),
+               stats.frameTime,
+               stats.flushCount,
+               stats.byteCount);
+  LogSpiCost(true);
+  LogSpiCost(false);
+  if (lines == runningDrawBufferLines) {
+    LogColorDepthCost(Components::LittleVgl::ColorDepths::Full);
+    LogColorDepthCost(Components::LittleVgl::ColorDepths::Reduced);
+    lvgl.SetColorDepth(Components::LittleVgl::ColorDepths::Full);
+  }
+}
+
+void DisplayApp::LogSpiCost(bool arrayList) {
+  // The same frame again, its EasyDMA chunks chained in hardware (array list + PPI) or restarted from the END interrupt
+  lcd.SetArrayListEnabled(arrayList);
+  const Drivers::SpiMaster::TransferStats before = lcd.GetTransferStats();
+  lv_obj_invalidate(lv_scr_act());
+  lv_refr_now(nullptr);
+  lvgl.WaitForLastFlush();
+  const Drivers::SpiMaster::TransferStats& after = lcd.GetTransferStats();
+  NRF_LOG_INFO("[Frame cost]   SPI %s: %lu chunks, %lu interrupts, setup %lu cycles, bus held %lu us",
+               arrayList ? "array list" : "chunked",
+               after.chunks - before.chunks,
+               after.interrupts - before.interrupts,
+               after.setupCycles - before.setupCycles,
+               (after.cycles - before.cycles) / 64);
+  lcd.SetArrayListEnabled(true);
+}
+
+void DisplayApp::LogColorDepthCost(Components::LittleVgl::ColorDepths depth) {
+  // The same frame again, sent as RGB565 or RGB444: the frame time includes the conversion, the SPI time the bytes saved
+  lvgl.SetColorDepth(depth);
+  const Drivers::SpiMaster::TransferStats before = lcd.GetTransferStats();
+  lv_obj_invalidate(lv_scr_act());
+  lv_refr_now(nullptr);
+  lvgl.WaitForLastFlush();
+  const auto& stats = lvgl.GetLastFrameStats();
+  const Drivers::SpiMaster::TransferStats& after = lcd.GetTransferStats();
+  NRF_LOG_INFO("[Frame cost]   %s: %lu ms, %lu B sent, SPI active %lu us",
+               depth == Components::LittleVgl::ColorDepths::Reduced ? "RGB444" : "RGB565",
+               stats.frameTime,
+               stats.byteCount,
+               (after.cycles - before.cycles) / 64);
+}
+#endif
+
 void DisplayApp::ApplyBrightness() {
   auto brightness = settingsController.GetBrightness();
   if (brightness != Controllers::BrightnessController::Levels::Low && brightness != Controllers::BrightnessController::Levels::Medium &&
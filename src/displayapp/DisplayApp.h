@@ -2,10 +2,12 @@
 #include <FreeRTOS.h>
 #include <queue.h>
 #include <task.h>
+#include <algorithm>
 #include <memory>
 #include <systemtask/Messages.h>
 #include "displayapp/apps/Apps.h"
 #include "displayapp/LittleVgl.h"
+#include "displayapp/FontCache.h"
 #include "displayapp/TouchEvents.h"
 #include "components/brightness/BrightnessController.h"
 #include "components/motor/MotorController.h"
@@ -67,7 +69,8 @@ namespace Pinetime {
                  Pinetime::Controllers::BrightnessController& brightnessController,
                  Pinetime::Controllers::TouchHandler& touchHandler,
                  Pinetime::Controllers::FS& filesystem,
-                 Pinetime::Drivers::SpiNorFlash& spiNorFlash);
+                 Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                 Pinetime::Controllers::FrameStatistics& frameStatistics);
       void Start(System::BootErrors error);
       void PushMessage(Display::Messages msg);
 
@@ -98,9 +101,11 @@ namespace Pinetime {
       Pinetime::Controllers::TouchHandler& touchHandler;
       Pinetime::Controllers::FS& filesystem;
       Pinetime::Drivers::SpiNorFlash& spiNorFlash;
+      Pinetime::Controllers::FrameStatistics& frameStatistics;
 
       Pinetime::Controllers::FirmwareValidator validator;
       Pinetime::Components::LittleVgl lvgl;
+      Pinetime::Components::FontCache fontCache;
       Pinetime::Controllers::Timer timer;
 
       AppControllers controllers;
@@ -131,6 +136,16 @@ namespace Pinetime {
       DisplayApp::FullRefreshDirections nextDirection;
       System::BootErrors bootError;
       void ApplyBrightness();
+      void ApplyColorDepth();
+      void ApplyDrawBufferLines();
+      void SetPixelDoubling(bool enabled);
+      void RefreshRetainedFrame();
+#ifdef LVGL_FRAME_BENCHMARK
+      void RunFrameCostBenchmark();
+      void LogFrameCost(const char* kind, uint8_t id, uint8_t lines);
+      void LogSpiCost(bool arrayList);
+      void LogColorDepthCost(Components::LittleVgl::ColorDepths depth);
+#endif
 
       static constexpr size_t returnAppStackSize = 10;
       Utility::StaticStack<Apps, returnAppStackSize> returnAppStack;
@@ -144,6 +159,16 @@ namespace Pinetime {
       // If this is to be changed, make sure the actual always on refresh rate is changed
       // by configuring the LCD refresh timings
       static constexpr uint32_t alwaysOnRefreshPeriod = 500;
+
+      // Height of the LVGL bands in each state, up to LVGL_DRAW_BUFFER_LINES. The always-on frames only redraw a few labels
+      // twice per second, their cost does not depend on the height: shorter bands hold the SPI bus, shared with the flash,
+      // for shorter transfers while the watch records its history and syncs.
+      static constexpr uint8_t runningDrawBufferLines = Components::LittleVgl::MaxDrawBufferLines();
+      static constexpr uint8_t alwaysOnDrawBufferLines =
+        std::max<uint8_t>(Components::LittleVgl::MinDrawBufferLines(), Components::LittleVgl::MaxDrawBufferLines() / 2);
+
+      // Heap left to a new screen before the unused cached fonts are freed
+      static constexpr size_t fontCacheMinFreeHeap = 12 * 1024;
     };
   }
 }
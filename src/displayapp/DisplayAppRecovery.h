@@ -34,6 +34,7 @@ namespace Pinetime {
     class AlarmController;
     class BrightnessController;
     class FS;
+    class FrameStatistics;
     class SimpleWeatherService;
     class MusicService;
     class NavigationService;
@@ -61,7 +62,8 @@ namespace Pinetime {
                  Pinetime::Controllers::BrightnessController& brightnessController,
                  Pinetime::Controllers::TouchHandler& touchHandler,
                  Pinetime::Controllers::FS& filesystem,
-                 Pinetime::Drivers::SpiNorFlash& spiNorFlash);
+                 Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                 Pinetime::Controllers::FrameStatistics& frameStatistics);
       void Start();
 
       void Start(Pinetime::System::BootErrors) {
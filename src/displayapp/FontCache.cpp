@@ -0,0 +1,122 @@
+#include "displayapp/FontCache.h"
+#include <FreeRTOS.h>
+#include <cstring>
+#include <nrf_log.h>
+
+using namespace Pinetime::Components;
+
+lv_font_t* FontCache::Load(const char* path) {
+  for (auto& entry : entries) {
+    if (entry.font != nullptr && !entry.stale && std::strncmp(entry.path, path, maxPathLength) == 0) {
+      statistics.hits++;
+      entry.references++;
+      entry.lastUse = ++useCounter;
+      return entry.font;
+    }
+  }
+
+  statistics.misses++;
+  const size_t freeHeapBefore = xPortGetFreeHeapSize();
+  lv_font_t* font = lv_font_load(path);
+  if (font == nullptr) {
+    return nullptr;
+  }
+  const size_t freeHeapAfter = xPortGetFreeHeapSize();
+  const size_t size = (freeHeapBefore > freeHeapAfter) ? freeHeapBefore - freeHeapAfter : 0;
+  NRF_LOG_INFO("[FontCache] Loaded %s (%d bytes)", path, size);
+
+  // Fonts with a longer path are not cached, Release() frees them
+  if (std::strlen(path) >= maxPathLength) {
+    return font;
+  }
+
+  Entry* entry = nullptr;
+  for (auto& candidate : entries) {
+    if (candidate.font == nullptr) {
+      entry = &candidate;
+      break;
+    }
+  }
+  if (entry == nullptr) {
+    entry = LeastRecentlyUsed();
+    if (entry == nullptr) {
+      return font;
+    }
+    Evict(*entry);
+  }
+
+  entry->font = font;
+  entry->size = size;
+  entry->references = 1;
+  entry->lastUse = ++useCounter;
+  std::strncpy(entry->path, path, maxPathLength);
+  statistics.bytes += size;
+  return font;
+}
+
+void FontCache::Release(lv_font_t* font) {
+  if (font == nullptr) {
+    return;
+  }
+
+  for (auto& entry : entries) {
+    if (entry.font == font) {
+      if (entry.references > 0) {
+        entry.references--;
+      }
+      if (entry.stale && entry.references == 0) {
+        Evict(entry);
+        return;
+      }
+      while (statistics.bytes > budget) {
+        Entry* victim = LeastRecentlyUsed();
+        if (victim == nullptr) {
+          break;
+        }
+        Evict(*victim);
+      }
+      return;
+    }
+  }
+  lv_font_free(font);
+}
+
+void FontCache::Trim(size_t minFreeHeap) {
+  while (xPortGetFreeHeapSize() < minFreeHeap) {
+    Entry* victim = LeastRecentlyUsed();
+    if (victim == nullptr) {
+      return;
+    }
+    Evict(*victim);
+  }
+}
+
+void FontCache::Invalidate() {
+  for (auto& entry : entries) {
+    if (entry.font == nullptr) {
+      continue;
+    }
+    if (entry.references == 0) {
+      Evict(entry);
+    } else {
+      entry.stale = true;
+    }
+  }
+}
+
+FontCache::Entry* FontCache::LeastRecentlyUsed() {
+  Entry* victim = nullptr;
+  for (auto& entry : entries) {
+    if (entry.font != nullptr && entry.references == 0 && (victim == nullptr || entry.lastUse < victim->lastUse)) {
+      victim = &entry;
+    }
+  }
+  return victim;
+}
+
+void FontCache::Evict(Entry& entry) {
+  lv_font_free(entry.font);
+  statistics.bytes -= entry.size;
+  statistics.evictions++;
+  entry = Entry {};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <lvgl/lvgl.h>
+
+// Heap bytes the fonts released by their screens may keep (set by CMake)
+#ifndef FONT_CACHE_BYTES
+  #define FONT_CACHE_BYTES 16384
+#endif
+
+namespace Pinetime {
+  namespace Components {
+    // Keeps the fonts loaded from the file system (lv_font_load) after the screen using them is closed,
+    // so going back to a watch face does not read and parse its fonts from the SPI flash again.
+    // Fonts are keyed by path: Invalidate() must be called when files are written, deleted or moved.
+    class FontCache {
+    public:
+      struct Statistics {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t evictions = 0;
+        size_t bytes = 0; // heap used by the cached fonts
+      };
+
+      FontCache() = default;
+      FontCache(const FontCache&) = delete;
+      FontCache& operator=(const FontCache&) = delete;
+      FontCache(FontCache&&) = delete;
+      FontCache& operator=(FontCache&&) = delete;
+
+      // path is on the LVGL file system, like "F:/fonts/teko.bin"
+      lv_font_t* Load(const char* path);
+      void Release(lv_font_t* font);
+
+      // Drops the unused fonts until the heap has at least minFreeHeap bytes free
+      void Trim(size_t minFreeHeap);
+
+      // Forgets all the fonts, their files may have changed. The fonts still used are freed when they are released
+      void Invalidate();
+
+      const Statistics& GetStatistics() const {
+        return statistics;
+      }
+
+    private:
+      static constexpr size_t budget = FONT_CACHE_BYTES;
+      static constexpr size_t maxPathLength = 32;
+      static constexpr size_t nbEntries = 6;
+
+      struct Entry {
+        lv_font_t* font = nullptr;
+        size_t size = 0;
+        uint32_t lastUse = 0;
+        uint8_t references = 0;
+        bool stale = false; // no longer returned by Load(), freed once released
+        char path[maxPathLength] = {};
+      };
+
+      Entry* LeastRecentlyUsed();
+      void Evict(Entry& entry);
+
+      std::array<Entry, nbEntries> entries;
+      uint32_t useCounter = 0;
+      Statistics statistics;
+    };
+  }
+}
@@ -3,9 +3,13 @@
 
 #include <FreeRTOS.h>
 #include <task.h>
+#include <algorithm>
+#include <cstring>
+#include <lvgl/src/lv_misc/lv_gc.h>
 #include "drivers/St7789.h"
 #include "littlefs/lfs.h"
 #include "components/fs/FS.h"
+#include "utility/ElapsedTime.h"
 
 using namespace Pinetime::Components;
 
@@ -16,11 +20,12 @@ namespace {
   }
 
   lv_fs_res_t lvglOpen(lv_fs_drv_t* drv, void* file_p, const char* path, lv_fs_mode_t /*mode*/) {
-    lfs_file_t* file = static_cast<lfs_file_t*>(file_p);
-    Pinetime::Controllers::FS* filesys = static_cast<Pinetime::Controllers::FS*>(drv->user_data);
-    int res = filesys->FileOpen(file, path, LFS_O_RDONLY);
+    auto* file = static_cast<Pinetime::Controllers::FileReadCache::File*>(file_p);
+    auto* cache = static_cast<Pinetime::Controllers::FileReadCache*>(drv->user_data);
+    int res = cache->Open(*file, path);
     if (res == 0) {
-      if (file->type == 0) {
+      if (file->file.type == 0) {
+        cache->Close(*file);
         return LV_FS_RES_FS_ERR;
       } else {
         return LV_FS_RES_OK;
@@ -30,25 +35,35 @@ namespace {
   }
 
   lv_fs_res_t lvglClose(lv_fs_drv_t* drv, void* file_p) {
-    Pinetime::Controllers::FS* filesys = static_cast<Pinetime::Controllers::FS*>(drv->user_data);
-    lfs_file_t* file = static_cast<lfs_file_t*>(file_p);
-    filesys->FileClose(file);
+    auto* cache = static_cast<Pinetime::Controllers::FileReadCache*>(drv->user_data);
+    auto* file = static_cast<Pinetime::Controllers::FileReadCache::File*>(file_p);
+    cache->Close(*file);
 
     return LV_FS_RES_OK;
   }
 
   lv_fs_res_t lvglRead(lv_fs_drv_t* drv, void* file_p, void* buf, uint32_t btr, uint32_t* br) {
-    Pinetime::Controllers::FS* filesys = static_cast<Pinetime::Controllers::FS*>(drv->user_data);
-    lfs_file_t* file = static_cast<lfs_file_t*>(file_p);
-    filesys->FileRead(file, static_cast<uint8_t*>(buf), btr);
-    *br = btr;
+    auto* cache = static_cast<Pinetime::Controllers::FileReadCache*>(drv->user_data);
+    auto* file = static_cast<Pinetime::Controllers::FileReadCache::File*>(file_p);
+    int res = cache->Read(*file, static_cast<uint8_t*>(buf), btr);
+    if (res < 0) {
+      *br = 0;
+      return LV_FS_RES_HW_ERR;
+    }
+    *br = res;
     return LV_FS_RES_OK;
   }
 
   lv_fs_res_t lvglSeek(lv_fs_drv_t* drv, void* file_p, uint32_t pos) {
-    Pinetime::Controllers::FS* filesys = static_cast<Pinetime::Controllers::FS*>(drv->user_data);
-    lfs_file_t* file = static_cast<lfs_file_t*>(file_p);
-    filesys->FileSeek(file, pos);
+    auto* cache = static_cast<Pinetime::Controllers::FileReadCache*>(drv->user_data);
+    auto* file = static_cast<Pinetime::Controllers::FileReadCache::File*>(file_p);
+    cache->Seek(*file, pos);
+    return LV_FS_RES_OK;
+  }
+
+  lv_fs_res_t lvglTell(lv_fs_drv_t* /*drv*/, void* file_p, uint32_t* pos_p) {
+    auto* file = static_cast<Pinetime::Controllers::FileReadCache::File*>(file_p);
+    *pos_p = file->position;
     return LV_FS_RES_OK;
   }
 }
@@ -58,6 +73,16 @@ static void disp_flush(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_
   lvgl->FlushDisplay(area, color_p);
 }
 
+static void wait_flush(lv_disp_drv_t* disp_drv) {
+  auto* lvgl = static_cast<LittleVgl*>(disp_drv->user_data);
+  lvgl->WaitForFlush();
+}
+
+static void monitor(lv_disp_drv_t* disp_drv, uint32_t time, uint32_t px) {
+  auto* lvgl = static_cast<LittleVgl*>(disp_drv->user_data);
+  lvgl->OnFrameRendered(time, px);
+}
+
 static void rounder(lv_disp_drv_t* disp_drv, lv_area_t* area) {
   auto* lvgl = static_cast<LittleVgl*>(disp_drv->user_data);
   if (lvgl->GetFullRefresh()) {
@@ -73,7 +98,10 @@ bool touchpad_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
   return lvgl->GetTouchPadInfo(data);
 }
 
-LittleVgl::LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Controllers::FS& filesystem) : lcd {lcd}, filesystem {filesystem} {
+LittleVgl::LittleVgl(Pinetime::Drivers::St7789& lcd,
+                     Pinetime::Controllers::FS& filesystem,
+                     Pinetime::Controllers::FrameStatistics& frameStatistics)
+  : lcd {lcd}, filesystem {filesystem}, frameStatistics {frameStatistics}, fileReadCache {filesystem} {
 }
 
 void LittleVgl::Init() {
@@ -85,8 +113,11 @@ void LittleVgl::Init() {
 }
 
 void LittleVgl::InitDisplay() {
-  lv_disp_buf_init(&disp_buf_2, buf2_1, buf2_2, LV_HOR_RES_MAX * 4); /*Initialize the display buffer*/
-  lv_disp_drv_init(&disp_drv);                                       /*Basic initialization*/
+  flushDone = xSemaphoreCreateBinary();
+  ASSERT(flushDone != nullptr);
+
+  lv_disp_buf_init(&disp_buf_2, buf2_1, buf2_2, drawBufferSize); /*Initialize the display buffer*/
+  lv_disp_drv_init(&disp_drv);                                   /*Basic initialization*/
 
   /*Set up the functions to access to your display*/
 
@@ -100,9 +131,14 @@ void LittleVgl::InitDisplay() {
   disp_drv.buffer = &disp_buf_2;
   disp_drv.user_data = this;
   disp_drv.rounder_cb = rounder;
+  /*Block the display task instead of spinning while LVGL waits for a band to be sent*/
+  disp_drv.wait_cb = wait_flush;
+  disp_drv.monitor_cb = monitor;
 
   /*Finally register the driver*/
-  lv_disp_drv_register(&disp_drv);
+  lv_disp_t* disp = lv_disp_drv_register(&disp_drv);
+  // The invalidated areas are coalesced by the refresh task itself, after the screens have updated their widgets
+  lv_task_set_cb(disp->refr_task, RefreshTask);
 }
 
 void LittleVgl::InitTouchpad() {
@@ -119,19 +155,25 @@ void LittleVgl::InitFileSystem() {
   lv_fs_drv_t fs_drv;
   lv_fs_drv_init(&fs_drv);
 
-  fs_drv.file_size = sizeof(lfs_file_t);
+  fs_drv.file_size = sizeof(Pinetime::Controllers::FileReadCache::File);
   fs_drv.letter = 'F';
   fs_drv.open_cb = lvglOpen;
   fs_drv.close_cb = lvglClose;
   fs_drv.read_cb = lvglRead;
   fs_drv.seek_cb = lvglSeek;
+  fs_drv.tell_cb = lvglTell;
 
-  fs_drv.user_data = &filesystem;
+  fs_drv.user_data = &fileReadCache;
 
   lv_fs_drv_register(&fs_drv);
 }
 
 void LittleVgl::SetFullRefresh(FullRefreshDirections direction) {
+  // A horizontal transition left over by a frame that sent no pixels must not block the next transition
+  if (IsHorizontalTransition()) {
+    scrollDirection = FullRefreshDirections::None;
+    lv_disp_set_direction(lv_disp_get_default(), 0);
+  }
   if (scrollDirection == FullRefreshDirections::None) {
     scrollDirection = direction;
     if (scrollDirection == FullRefreshDirections::Down) {
@@ -146,12 +188,176 @@ void LittleVgl::SetFullRefresh(FullRefreshDirections direction) {
       lv_disp_set_direction(lv_disp_get_default(), 4);
     }
   }
-  fullRefresh = true;
+  // The vertical transitions scroll the whole display. The horizontal ones only change the render order, so they keep
+  // the areas invalidated by the screens: the pixels both screens share (mostly the background) are not sent again
+  if (!IsHorizontalTransition()) {
+    fullRefresh = true;
+  }
+}
+
+bool LittleVgl::IsHorizontalTransition() const {
+  return scrollDirection == FullRefreshDirections::Left || scrollDirection == FullRefreshDirections::Right ||
+         scrollDirection == FullRefreshDirections::LeftAnim || scrollDirection == FullRefreshDirections::RightAnim;
+}
+
+void LittleVgl::WaitForLastFlush() {
+  while (disp_buf_2.flushing) {
+    WaitForFlush();
+  }
+}
+
+void LittleVgl::SetPixelDoubling(bool enabled) {
+  if (enabled == pixelDoubling) {
+    return;
+  }
+  // The draw buffers are resized: the last band must be sent before LVGL gets them back
+  WaitForLastFlush();
+  pixelDoubling = enabled;
+
+  disp_drv.hor_res = enabled ? LV_HOR_RES_MAX / 2 : LV_HOR_RES_MAX;
+  disp_drv.ver_res = enabled ? LV_VER_RES_MAX / 2 : LV_VER_RES_MAX;
+  // Also resizes the screens to the new resolution
+  ApplyDrawBufferSize();
+  lv_obj_invalidate(lv_scr_act());
+}
+
+void LittleVgl::SetDrawBufferLines(uint8_t lines) {
+  lines = std::clamp(lines, minWriteLines, nbWriteLines);
+  if (lines == drawBufferLines) {
+    return;
+  }
+  WaitForLastFlush();
+  drawBufferLines = lines;
+  ApplyDrawBufferSize();
+}
+
+void LittleVgl::ApplyDrawBufferSize() {
+  uint32_t size = LV_HOR_RES_MAX * drawBufferLines;
+  if (pixelDoubling) {
+    // A quarter of each band is rendered, the rest receives the doubled pixels
+    size /= 4;
+  }
+  lv_disp_buf_init(&disp_buf_2, buf2_1, buf2_2, size);
+  lv_disp_drv_update(lv_disp_get_default(), &disp_drv);
+}
+
+void LittleVgl::DoublePixels(lv_color_t* pixels, uint16_t width, uint16_t height) {
+  // In place, from the last row to the first one: a doubled row never overlaps a source row that is still needed
+  const uint16_t doubledWidth = width * 2;
+  for (int32_t row = height - 1; row >= 0; row--) {
+    const lv_color_t* in = pixels + (row * width);
+    lv_color_t* out = pixels + ((row * 2 + 1) * doubledWidth);
+    for (int32_t column = width - 1; column >= 0; column--) {
+      out[column * 2 + 1] = in[column];
+      out[column * 2] = in[column];
+    }
+    std::memcpy(out - doubledWidth, out, doubledWidth * sizeof(lv_color_t));
+  }
+}
+
+uint32_t LittleVgl::FlushCost(const lv_area_t& area) const {
+  // LVGL splits an area in as many flushes as needed to fit the draw buffer, each of them sets a new address window
+  const uint32_t width = lv_area_get_width(&area);
+  const uint32_t height = lv_area_get_height(&area);
+  const uint32_t linesPerFlush = std::max<uint32_t>(1, disp_buf_2.size / width);
+  const uint32_t nbFlushes = (height + linesPerFlush - 1) / linesPerFlush;
+  return (nbFlushes * addressWindowCostInPixels) + (width * height);
+}
+
+void LittleVgl::RefreshTask(lv_task_t* task) {
+  // Runs in place of the LVGL refresh task, after the tasks of the screens in the same lv_task_handler() call: the areas
+  // they invalidated (label updates) are all in the list
+  auto* disp = static_cast<lv_disp_t*>(task->user_data);
+  static_cast<LittleVgl*>(disp->driver.user_data)->CoalesceInvalidatedAreas(disp);
+  _lv_disp_refr_task(task);
+}
+
+void LittleVgl::CoalesceInvalidatedAreas(lv_disp_t* disp) {
+  uint16_t nbAreas = disp->inv_p;
+  pendingInvalidatedAreas += nbAreas;
+
+  // The scroll offset computation in FlushDisplay() relies on full screen areas
+  if (nbAreas < 2 || scrollDirection == FullRefreshDirections::Up || scrollDirection == FullRefreshDirections::Down) {
+    return;
+  }
+
+  // Greedily merge the pairs of areas whose bounding box is cheaper to send than both areas separately
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (uint16_t i = 0; i < nbAreas; i++) {
+      for (uint16_t j = i + 1; j < nbAreas; j++) {
+        lv_area_t joined;
+        _lv_area_join(&joined, &disp->inv_areas[i], &disp->inv_areas[j]);
+        if (FlushCost(joined) <= FlushCost(disp->inv_areas[i]) + FlushCost(disp->inv_areas[j])) {
+          lv_area_copy(&disp->inv_areas[i], &joined);
+          nbAreas--;
+          lv_area_copy(&disp->inv_areas[j], &disp->inv_areas[nbAreas]);
+          merged = true;
+          j = i;
+        }
+      }
+    }
+  }
+
+  disp->inv_p = nbAreas;
+}
+
+void LittleVgl::SetColorDepth(ColorDepths depth) {
+  colorDepth = depth;
+}
+
+size_t LittleVgl::ConvertToRgb444(lv_color_t* pixels, size_t count) {
+  // Packs 2 pixels in 3 bytes (RRRRGGGG BBBBRRRR GGGGBBBB). The output is smaller than the input
+  // so the conversion is done in place, front to back. The pixels are stored byte swapped (LV_COLOR_16_SWAP)
+  const auto* in = reinterpret_cast<const uint8_t*>(pixels);
+  auto* out = reinterpret_cast<uint8_t*>(pixels);
+  size_t outIndex = 0;
+  for (size_t i = 0; i < count; i += 2) {
+    uint8_t r = in[0] >> 4;
+    uint8_t g = ((in[0] & 0x07) << 1) | (in[1] >> 7);
+    uint8_t b = (in[1] & 0x1f) >> 1;
+    out[outIndex++] = (r << 4) | g;
+    if (i + 1 < count) {
+      uint8_t r2 = in[2] >> 4;
+      uint8_t g2 = ((in[2] & 0x07) << 1) | (in[3] >> 7);
+      uint8_t b2 = (in[3] & 0x1f) >> 1;
+      out[outIndex++] = (b << 4) | r2;
+      out[outIndex++] = (g2 << 4) | b2;
+    } else {
+      // An odd last pixel is complete with this byte, its low nibble is padding that the display drops when CS goes high
+      out[outIndex++] = b << 4;
+    }
+    in += 4;
+  }
+  return outIndex;
+}
+
+size_t LittleVgl::PreparePixels(lv_color_t* pixels, size_t count) {
+  size_t size = count * sizeof(lv_color_t);
+  if (lcd.GetPixelFormat() == Pinetime::Drivers::St7789::PixelFormats::Rgb444) {
+    size = ConvertToRgb444(pixels, count);
+  }
+  currentByteCount += size;
+  return size;
 }
 
 void LittleVgl::FlushDisplay(const lv_area_t* area, lv_color_t* color_p) {
   uint16_t y1, y2, width, height = 0;
 
+  lv_area_t doubledArea;
+  if (pixelDoubling) {
+    DoublePixels(color_p, lv_area_get_width(area), lv_area_get_height(area));
+    doubledArea.x1 = area->x1 * 2;
+    doubledArea.y1 = area->y1 * 2;
+    doubledArea.x2 = (area->x2 * 2) + 1;
+    doubledArea.y2 = (area->y2 * 2) + 1;
+    area = &doubledArea;
+  }
+
+  lcd.SetPixelFormat(colorDepth == ColorDepths::Reduced ? Pinetime::Drivers::St7789::PixelFormats::Rgb444
+                                                         : Pinetime::Drivers::St7789::PixelFormats::Rgb565);
+
   if ((scrollDirection == LittleVgl::FullRefreshDirections::Down) && (area->y2 == visibleNbLines - 1)) {
     writeOffset = ((writeOffset + totalNbLines) - visibleNbLines) % totalNbLines;
   } else if ((scrollDirection == FullRefreshDirections::Up) && (area->y1 == 0)) {
@@ -198,36 +404,94 @@ void LittleVgl::FlushDisplay(const lv_area_t* area, lv_color_t* color_p) {
       scrollOffset = scrollOffset % totalNbLines;
       lcd.VerticalScrollStartAddress(scrollOffset);
     }
-  } else if (scrollDirection == FullRefreshDirections::Left or scrollDirection == FullRefreshDirections::LeftAnim) {
-    if (area->x2 == visibleNbLines - 1) {
-      scrollDirection = FullRefreshDirections::None;
-      lv_disp_set_direction(lv_disp_get_default(), 0);
-    }
-  } else if (scrollDirection == FullRefreshDirections::Right or scrollDirection == FullRefreshDirections::RightAnim) {
-    if (area->x1 == 0) {
-      scrollDirection = FullRefreshDirections::None;
-      lv_disp_set_direction(lv_disp_get_default(), 0);
-    }
   }
 
+  currentFlushCount++;
+  currentAddressWindowCount++;
+
+  // The transfers are only queued here: LVGL is told that the buffer can be reused (lv_disp_flush_ready)
+  // from the SPI end-of-transfer interrupt, and renders the next band in the other buffer in the meantime
   if (y2 < y1) {
     height = totalNbLines - y1;
 
+    // Each part is converted from its own start so an odd pixel count in the first one cannot shift the second one
+    uint16_t pixOffset = width * height;
+    uint16_t wrappedHeight = y2 + 1;
+    size_t size = (height > 0) ? PreparePixels(color_p, pixOffset) : 0;
+    size_t wrappedSize = PreparePixels(color_p + pixOffset, width * wrappedHeight);
+
+    const Utility::ElapsedTime blocked;
     if (height > 0) {
-      lcd.DrawBuffer(area->x1, y1, width, height, reinterpret_cast<const uint8_t*>(color_p), width * height * 2);
+      lcd.DrawBuffer(area->x1, y1, width, height, reinterpret_cast<const uint8_t*>(color_p), size);
+      currentAddressWindowCount++;
     }
-
-    uint16_t pixOffset = width * height;
-    height = y2 + 1;
-    lcd.DrawBuffer(area->x1, 0, width, height, reinterpret_cast<const uint8_t*>(color_p + pixOffset), width * height * 2);
+    lcd.DrawBuffer(area->x1,
+                   0,
+                   width,
+                   wrappedHeight,
+                   reinterpret_cast<const uint8_t*>(color_p + pixOffset),
+                   wrappedSize,
+                   OnFlushDone,
+                   this);
+    currentSpiBlockedTime += blocked.Microseconds();
 
   } else {
-    lcd.DrawBuffer(area->x1, y1, width, height, reinterpret_cast<const uint8_t*>(color_p), width * height * 2);
+    size_t size = PreparePixels(color_p, width * height);
+    const Utility::ElapsedTime blocked;
+    lcd.DrawBuffer(area->x1, y1, width, height, reinterpret_cast<const uint8_t*>(color_p), size, OnFlushDone, this);
+    currentSpiBlockedTime += blocked.Microseconds();
+  }
+
+  // The areas of a horizontal transition do not necessarily reach the edge of the display, it ends with the frame
+  if (IsHorizontalTransition() && lv_disp_flush_is_last(&disp_drv)) {
+    scrollDirection = FullRefreshDirections::None;
+    lv_disp_set_direction(lv_disp_get_default(), 0);
   }
+}
+
+// Called from the SPI interrupt handler
+void LittleVgl::OnFlushDone(void* instance) {
+  auto* lvgl = static_cast<LittleVgl*>(instance);
+  lv_disp_flush_ready(&lvgl->disp_drv);
+
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  xSemaphoreGiveFromISR(lvgl->flushDone, &xHigherPriorityTaskWoken);
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+void LittleVgl::WaitForFlush() {
+  const Utility::ElapsedTime blocked;
+  // LVGL checks the flushing flag again after each call, so a stale give or a timeout only costs one more loop
+  xSemaphoreTake(flushDone, pdMS_TO_TICKS(5));
+  currentSpiBlockedTime += blocked.Microseconds();
+}
 
-  // IMPORTANT!!!
-  // Inform the graphics library that you are ready with the flushing
-  lv_disp_flush_ready(&disp_drv);
+void LittleVgl::OnFrameRendered(uint32_t time, uint32_t pixelCount) {
+  // LVGL returns as soon as the last band is queued, the frame is on the display once it is sent
+  const Utility::ElapsedTime lastFlush;
+  WaitForLastFlush();
+  time += (lastFlush.Microseconds() + 500) / 1000;
+
+  lastFrameStats.frameTime = time;
+  lastFrameStats.pixelCount = pixelCount;
+  lastFrameStats.flushCount = currentFlushCount;
+  lastFrameStats.invalidatedAreas = pendingInvalidatedAreas;
+  lastFrameStats.addressWindows = currentAddressWindowCount;
+  lastFrameStats.byteCount = currentByteCount;
+
+  Controllers::FrameStatistics::Frame frame;
+  frame.renderTime = std::min<uint32_t>(time, UINT16_MAX);
+  frame.spiBlockedTime = std::min<uint32_t>(currentSpiBlockedTime, UINT16_MAX);
+  frame.flushCount = currentFlushCount;
+  frame.lvglTaskCount = std::min<uint32_t>(_lv_ll_get_len(&LV_GC_ROOT(_lv_task_ll)), UINT8_MAX);
+  frame.byteCount = currentByteCount;
+  frameStatistics.AddFrame(frame);
+
+  currentFlushCount = 0;
+  currentAddressWindowCount = 0;
+  currentByteCount = 0;
+  currentSpiBlockedTime = 0;
+  pendingInvalidatedAreas = 0;
 }
 
 void LittleVgl::SetNewTouchPoint(int16_t x, int16_t y, bool contact) {
@@ -265,8 +529,9 @@ void LittleVgl::ClearTouchState() {
 }
 
 bool LittleVgl::GetTouchPadInfo(lv_indev_data_t* ptr) {
-  ptr->point.x = touchPoint.x;
-  ptr->point.y = touchPoint.y;
+  // (-1, -1) is no touch, it must not become the top left pixel of the smaller display
+  ptr->point.x = (pixelDoubling && touchPoint.x >= 0) ? touchPoint.x / 2 : touchPoint.x;
+  ptr->point.y = (pixelDoubling && touchPoint.y >= 0) ? touchPoint.y / 2 : touchPoint.y;
   if (tapped) {
     ptr->state = LV_INDEV_STATE_PR;
   } else {
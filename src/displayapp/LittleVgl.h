@@ -1,7 +1,16 @@
 #pragma once
 
+#include <FreeRTOS.h>
+#include <semphr.h>
 #include <lvgl/lvgl.h>
 #include <components/fs/FS.h>
+#include "components/fs/FileReadCache.h"
+#include "components/display/FrameStatistics.h"
+
+// Height of the 2 draw buffers LVGL renders in, in lines (set by CMake)
+#ifndef LVGL_DRAW_BUFFER_LINES
+  #define LVGL_DRAW_BUFFER_LINES 4
+#endif
 
 namespace Pinetime {
   namespace Drivers {
@@ -12,7 +21,20 @@ namespace Pinetime {
     class LittleVgl {
     public:
       enum class FullRefreshDirections { None, Up, Down, Left, Right, LeftAnim, RightAnim };
-      LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Controllers::FS& filesystem);
+      enum class ColorDepths { Full, Reduced };
+
+      struct FrameStats {
+        uint32_t frameTime = 0; // ms, from the start of rendering until the last band is sent
+        uint32_t pixelCount = 0;
+        uint16_t flushCount = 0;
+        uint16_t invalidatedAreas = 0; // areas invalidated by the widgets, before coalescing
+        uint16_t addressWindows = 0;   // address windows sent to the display
+        uint32_t byteCount = 0;        // pixel data sent to the display
+      };
+
+      LittleVgl(Pinetime::Drivers::St7789& lcd,
+                Pinetime::Controllers::FS& filesystem,
+                Pinetime::Controllers::FrameStatistics& frameStatistics);
 
       LittleVgl(const LittleVgl&) = delete;
       LittleVgl& operator=(const LittleVgl&) = delete;
@@ -22,8 +44,46 @@ namespace Pinetime {
       void Init();
 
       void FlushDisplay(const lv_area_t* area, lv_color_t* color_p);
+      void WaitForFlush();
+      void WaitForLastFlush();
+      void OnFrameRendered(uint32_t time, uint32_t pixelCount);
       bool GetTouchPadInfo(lv_indev_data_t* ptr);
       void SetFullRefresh(FullRefreshDirections direction);
+      // Reduced: RGB444 over SPI, 25% less data per frame. Applied from the next flushed band
+      void SetColorDepth(ColorDepths depth);
+      // Renders a 120x120 display and doubles every pixel when flushing. The current screen must lay itself out again after
+      // switching (Screen::SetLowResolution), the whole display is redrawn
+      void SetPixelDoubling(bool enabled);
+
+      bool IsPixelDoubling() const {
+        return pixelDoubling;
+      }
+
+      // Shorter bands use less of the draw buffers, applied from the next frame
+      void SetDrawBufferLines(uint8_t lines);
+
+      uint8_t GetDrawBufferLines() const {
+        return drawBufferLines;
+      }
+
+      static constexpr uint8_t MaxDrawBufferLines() {
+        return nbWriteLines;
+      }
+
+      static constexpr uint8_t MinDrawBufferLines() {
+        return minWriteLines;
+      }
+
+      // Part of the draw buffers used by bands of the given height
+      static constexpr uint32_t DrawBufferBytes(uint8_t lines) {
+        return 2 * LV_HOR_RES_MAX * lines * sizeof(lv_color_t);
+      }
+
+      // RAM taken by the draw buffers, whatever the height of the bands: sized for LVGL_DRAW_BUFFER_LINES
+      static constexpr uint32_t StaticDrawBufferBytes() {
+        return sizeof(buf2_1) + sizeof(buf2_2);
+      }
+
       void SetNewTouchPoint(int16_t x, int16_t y, bool contact);
       void CancelTap();
       void ClearTouchState();
@@ -36,25 +96,62 @@ namespace Pinetime {
         return returnValue;
       }
 
+      const FrameStats& GetLastFrameStats() const {
+        return lastFrameStats;
+      }
+
     private:
       void InitDisplay();
       void InitTouchpad();
       void InitFileSystem();
+      static void OnFlushDone(void* instance);
+      static void RefreshTask(lv_task_t* task);
+      void CoalesceInvalidatedAreas(lv_disp_t* disp);
+      size_t PreparePixels(lv_color_t* pixels, size_t count);
+      static void DoublePixels(lv_color_t* pixels, uint16_t width, uint16_t height);
+      void ApplyDrawBufferSize();
+      static size_t ConvertToRgb444(lv_color_t* pixels, size_t count);
 
       Pinetime::Drivers::St7789& lcd;
       Pinetime::Controllers::FS& filesystem;
+      Pinetime::Controllers::FrameStatistics& frameStatistics;
+      Pinetime::Controllers::FileReadCache fileReadCache;
+
+      static constexpr uint8_t nbWriteLines = LVGL_DRAW_BUFFER_LINES;
+      // A quarter of a band must hold a line of the pixel doubling mode
+      static constexpr uint8_t minWriteLines = 2;
+      // The 2 draw buffers take 960 B per line: 40 lines already use 37.5 KB of the 64 KB of RAM
+      static constexpr uint8_t maxWriteLines = 40;
+      static constexpr uint32_t drawBufferSize = LV_HOR_RES_MAX * nbWriteLines;
+      static_assert(nbWriteLines >= minWriteLines && nbWriteLines <= maxWriteLines, "LVGL_DRAW_BUFFER_LINES must be between 2 and 40");
 
       lv_disp_buf_t disp_buf_2;
-      lv_color_t buf2_1[LV_HOR_RES_MAX * 4];
-      lv_color_t buf2_2[LV_HOR_RES_MAX * 4];
+      lv_color_t buf2_1[drawBufferSize];
+      lv_color_t buf2_2[drawBufferSize];
 
       lv_disp_drv_t disp_drv;
+      SemaphoreHandle_t flushDone = nullptr;
+
+      FrameStats lastFrameStats;
+      uint16_t currentFlushCount = 0;
+      uint16_t currentAddressWindowCount = 0;
+      uint16_t pendingInvalidatedAreas = 0;
+      uint32_t currentByteCount = 0;
+      // us, the display task sleeps while it waits for the SPI
+      uint32_t currentSpiBlockedTime = 0;
+      ColorDepths colorDepth = ColorDepths::Full;
 
       bool fullRefresh = false;
-      static constexpr uint8_t nbWriteLines = 4;
+      bool pixelDoubling = false;
+      uint8_t drawBufferLines = nbWriteLines;
       static constexpr uint16_t totalNbLines = 320;
       static constexpr uint16_t visibleNbLines = 240;
 
+      // Cost of an extra address window (commands, DMA setup, LVGL area overhead) expressed in pixels sent
+      static constexpr uint32_t addressWindowCostInPixels = 160;
+      uint32_t FlushCost(const lv_area_t& area) const;
+      bool IsHorizontalTransition() const;
+
       static constexpr uint8_t MaxScrollOffset() {
         return LV_VER_RES_MAX - nbWriteLines;
       }
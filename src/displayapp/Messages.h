@@ -24,6 +24,8 @@ namespace Pinetime {
         AlarmTriggered,
         Chime,
         BleRadioEnableToggle,
+        // Files were written, deleted or moved over BLE
+        FilesChanged,
       };
     }
   }
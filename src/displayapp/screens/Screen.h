@@ -40,6 +40,21 @@ namespace Pinetime {
           return false;
         }
 
+        /** @return true if the screen lays itself out on the 120x120 display used by the pixel doubling AOD mode */
+        virtual bool SupportsPixelDoubling() const {
+          return false;
+        }
+
+        /** Called when the pixel doubling AOD mode is switched while the screen is displayed: its objects are laid out again
+         * for the new display size instead of the whole screen being recreated */
+        virtual void SetLowResolution(bool /*enabled*/) {
+        }
+
+        /** @return true if the screen still looks right with 12-bit colours, which are faster to send to the display */
+        virtual bool AllowReducedColorDepth() const {
+          return false;
+        }
+
       protected:
         bool running = true;
       };
@@ -54,17 +54,13 @@ WatchFaceDigital::WatchFaceDigital(Controllers::DateTime& dateTimeController,
   lv_obj_align(temperature, nullptr, LV_ALIGN_IN_TOP_MID, 20, 50);
 
   label_date = lv_label_create(lv_scr_act(), nullptr);
-  lv_obj_align(label_date, lv_scr_act(), LV_ALIGN_CENTER, 0, 60);
   lv_obj_set_style_local_text_color(label_date, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, lv_color_hex(0x999999));
 
   label_time = lv_label_create(lv_scr_act(), nullptr);
-  lv_obj_set_style_local_text_font(label_time, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, &jetbrains_mono_extrabold_compressed);
-
   lv_obj_align(label_time, lv_scr_act(), LV_ALIGN_IN_RIGHT_MID, 0, 0);
 
   label_time_ampm = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_text_static(label_time_ampm, "");
-  lv_obj_align(label_time_ampm, lv_scr_act(), LV_ALIGN_IN_RIGHT_MID, -30, -55);
 
   heartbeatIcon = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_text_static(heartbeatIcon, Symbols::heartBeat);
@@ -86,6 +82,8 @@ WatchFaceDigital::WatchFaceDigital(Controllers::DateTime& dateTimeController,
   lv_label_set_text_static(stepIcon, Symbols::shoe);
   lv_obj_align(stepIcon, stepValue, LV_ALIGN_OUT_LEFT_MID, -5, 0);
 
+  ApplyLayout();
+
   taskRefresh = lv_task_create(RefreshTaskCallback, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_MID, this);
   Refresh();
 }
@@ -95,6 +93,42 @@ WatchFaceDigital::~WatchFaceDigital() {
   lv_obj_clean(lv_scr_act());
 }
 
+void WatchFaceDigital::SetLowResolution(bool enabled) {
+  lowResolution = enabled;
+  ApplyLayout();
+  // The time and the date are written again, in the format of the new layout
+  currentDateTime.Invalidate();
+  currentDate.Invalidate();
+  Refresh();
+}
+
+void WatchFaceDigital::ApplyLayout() {
+  if (lowResolution) {
+    lv_obj_set_style_local_text_font(label_time, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, &jetbrains_mono_42);
+    lv_obj_set_style_local_text_letter_space(label_time, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, -2);
+  } else {
+    lv_obj_set_style_local_text_font(label_time, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, &jetbrains_mono_extrabold_compressed);
+    lv_obj_set_style_local_text_letter_space(label_time, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, 0);
+  }
+  lv_obj_align(label_date, lv_scr_act(), LV_ALIGN_CENTER, 0, lowResolution ? 30 : 60);
+  lv_obj_align(label_time_ampm, lv_scr_act(), LV_ALIGN_IN_RIGHT_MID, lowResolution ? -15 : -30, lowResolution ? -30 : -55);
+
+  // Keep the time, date and steps only, the other items would not fit on the smaller display
+  lv_obj_set_hidden(weatherIcon, lowResolution);
+  lv_obj_set_hidden(temperature, lowResolution);
+  lv_obj_set_hidden(heartbeatIcon, lowResolution);
+  lv_obj_set_hidden(heartbeatValue, lowResolution);
+
+  // The other objects keep their alignment, on the resized screen
+  lv_obj_realign(notificationIcon);
+  lv_obj_realign(weatherIcon);
+  lv_obj_realign(temperature);
+  lv_obj_realign(heartbeatIcon);
+  lv_obj_realign(heartbeatValue);
+  lv_obj_realign(stepValue);
+  lv_obj_realign(stepIcon);
+}
+
 void WatchFaceDigital::Refresh() {
   statusIcons.Update();
 
@@ -131,7 +165,9 @@ void WatchFaceDigital::Refresh() {
     if (currentDate.IsUpdated()) {
       uint16_t year = dateTimeController.Year();
       uint8_t day = dateTimeController.Day();
-      if (settingsController.GetClockType() == Controllers::Settings::ClockType::H24) {
+      if (lowResolution) {
+        lv_label_set_text_fmt(label_date, "%s %d", dateTimeController.DayOfWeekShortToString(), day);
+      } else if (settingsController.GetClockType() == Controllers::Settings::ClockType::H24) {
         lv_label_set_text_fmt(label_date,
                               "%s %d %s %d",
                               dateTimeController.DayOfWeekShortToString(),
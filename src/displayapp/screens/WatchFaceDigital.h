@@ -41,6 +41,12 @@ namespace Pinetime {
 
         void Refresh() override;
 
+        bool SupportsPixelDoubling() const override {
+          return true;
+        }
+
+        void SetLowResolution(bool enabled) override;
+
       private:
         uint8_t displayedHour = -1;
         uint8_t displayedMinute = -1;
@@ -65,6 +71,9 @@ namespace Pinetime {
         lv_obj_t* weatherIcon;
         lv_obj_t* temperature;
 
+        // Laid out for the 120x120 display of the pixel doubling AOD mode
+        bool lowResolution = lv_disp_get_hor_res(nullptr) < LV_HOR_RES_MAX;
+
         Controllers::DateTime& dateTimeController;
         Controllers::NotificationManager& notificationManager;
         Controllers::Settings& settingsController;
@@ -74,6 +83,8 @@ namespace Pinetime {
 
         lv_task_t* taskRefresh;
         Widgets::StatusIcons statusIcons;
+
+        void ApplyLayout();
       };
     }
 
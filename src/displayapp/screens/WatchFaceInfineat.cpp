@@ -9,6 +9,7 @@
 #include "components/ble/BleController.h"
 #include "components/ble/NotificationManager.h"
 #include "components/motion/MotionController.h"
+#include "displayapp/FontCache.h"
 
 using namespace Pinetime::Applications::Screens;
 
@@ -125,23 +126,25 @@ WatchFaceInfineat::WatchFaceInfineat(Controllers::DateTime& dateTimeController,
                                      Controllers::NotificationManager& notificationManager,
                                      Controllers::Settings& settingsController,
                                      Controllers::MotionController& motionController,
-                                     Controllers::FS& filesystem)
+                                     Controllers::FS& filesystem,
+                                     Components::FontCache& fontCache)
   : currentDateTime {{}},
     dateTimeController {dateTimeController},
     batteryController {batteryController},
     bleController {bleController},
     notificationManager {notificationManager},
     settingsController {settingsController},
-    motionController {motionController} {
+    motionController {motionController},
+    fontCache {fontCache} {
   lfs_file f = {};
   if (filesystem.FileOpen(&f, "/fonts/teko.bin", LFS_O_RDONLY) >= 0) {
     filesystem.FileClose(&f);
-    font_teko = lv_font_load("F:/fonts/teko.bin");
+    font_teko = fontCache.Load("F:/fonts/teko.bin");
   }
 
   if (filesystem.FileOpen(&f, "/fonts/bebas.bin", LFS_O_RDONLY) >= 0) {
     filesystem.FileClose(&f);
-    font_bebas = lv_font_load("F:/fonts/bebas.bin");
+    font_bebas = fontCache.Load("F:/fonts/bebas.bin");
   }
 
   // Side Cover
@@ -303,12 +306,8 @@ WatchFaceInfineat::WatchFaceInfineat(Controllers::DateTime& dateTimeController,
 WatchFaceInfineat::~WatchFaceInfineat() {
   lv_task_del(taskRefresh);
 
-  if (font_bebas != nullptr) {
-    lv_font_free(font_bebas);
-  }
-  if (font_teko != nullptr) {
-    lv_font_free(font_teko);
-  }
+  fontCache.Release(font_bebas);
+  fontCache.Release(font_teko);
 
   lv_obj_clean(lv_scr_act());
 }
@@ -29,7 +29,6 @@ WatchFaceTerminal::WatchFaceTerminal(Controllers::DateTime& dateTimeController,
     motionController {motionController} {
   batteryValue = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_recolor(batteryValue, true);
-  lv_obj_align(batteryValue, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, -20);
 
   connectState = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_recolor(connectState, true);
@@ -40,19 +39,12 @@ WatchFaceTerminal::WatchFaceTerminal(Controllers::DateTime& dateTimeController,
 
   label_date = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_recolor(label_date, true);
-  lv_obj_align(label_date, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, -40);
 
   label_prompt_1 = lv_label_create(lv_scr_act(), nullptr);
-  lv_obj_align(label_prompt_1, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, -80);
-  lv_label_set_text_static(label_prompt_1, "user@watch:~ $ now");
-
   label_prompt_2 = lv_label_create(lv_scr_act(), nullptr);
-  lv_obj_align(label_prompt_2, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, 60);
-  lv_label_set_text_static(label_prompt_2, "user@watch:~ $");
 
   label_time = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_recolor(label_time, true);
-  lv_obj_align(label_time, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, -60);
 
   heartbeatValue = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_recolor(heartbeatValue, true);
@@ -62,6 +54,8 @@ WatchFaceTerminal::WatchFaceTerminal(Controllers::DateTime& dateTimeController,
   lv_label_set_recolor(stepValue, true);
   lv_obj_align(stepValue, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, 0);
 
+  ApplyLayout();
+
   taskRefresh = lv_task_create(RefreshTaskCallback, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_MID, this);
   Refresh();
 }
@@ -71,13 +65,58 @@ WatchFaceTerminal::~WatchFaceTerminal() {
   lv_obj_clean(lv_scr_act());
 }
 
+void WatchFaceTerminal::SetLowResolution(bool enabled) {
+  lowResolution = enabled;
+  ApplyLayout();
+  // The battery, the time and the date are written again, in the format of the new layout
+  batteryPercentRemaining.Invalidate();
+  currentDateTime.Invalidate();
+  currentDate.Invalidate();
+  Refresh();
+}
+
+void WatchFaceTerminal::ApplyLayout() {
+  // Only 5 short lines fit on the smaller display: prompt, time, date, battery and an empty prompt
+  lv_obj_set_hidden(notificationIcon, lowResolution);
+  lv_obj_set_hidden(connectState, lowResolution);
+  lv_obj_set_hidden(heartbeatValue, lowResolution);
+  lv_obj_set_hidden(stepValue, lowResolution);
+  if (lowResolution) {
+    lv_label_set_text_static(label_prompt_1, "$ now");
+    lv_label_set_text_static(label_prompt_2, "$");
+    lv_obj_align(label_prompt_1, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, -40);
+    lv_obj_align(label_time, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, -20);
+    lv_obj_align(label_date, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, 0);
+    lv_obj_align(batteryValue, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, 20);
+    lv_obj_align(label_prompt_2, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, 40);
+  } else {
+    lv_label_set_text_static(label_prompt_1, "user@watch:~ $ now");
+    lv_label_set_text_static(label_prompt_2, "user@watch:~ $");
+    lv_obj_align(label_prompt_1, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, -80);
+    lv_obj_align(label_time, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, -60);
+    lv_obj_align(label_date, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, -40);
+    lv_obj_align(batteryValue, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, -20);
+    lv_obj_align(label_prompt_2, lv_scr_act(), LV_ALIGN_IN_LEFT_MID, 0, 60);
+  }
+
+  // The other lines keep their alignment, on the resized screen
+  lv_obj_realign(connectState);
+  lv_obj_realign(notificationIcon);
+  lv_obj_realign(heartbeatValue);
+  lv_obj_realign(stepValue);
+}
+
 void WatchFaceTerminal::Refresh() {
   powerPresent = batteryController.IsPowerPresent();
   batteryPercentRemaining = batteryController.PercentRemaining();
   if (batteryPercentRemaining.IsUpdated() || powerPresent.IsUpdated()) {
-    lv_label_set_text_fmt(batteryValue, "[BATT]#387b54 %d%%", batteryPercentRemaining.Get());
+    if (lowResolution) {
+      lv_label_set_text_fmt(batteryValue, "#387b54 %d%%", batteryPercentRemaining.Get());
+    } else {
+      lv_label_set_text_fmt(batteryValue, "[BATT]#387b54 %d%%", batteryPercentRemaining.Get());
+    }
     if (batteryController.IsPowerPresent()) {
-      lv_label_ins_text(batteryValue, LV_LABEL_POS_LAST, " Charging");
+      lv_label_ins_text(batteryValue, LV_LABEL_POS_LAST, lowResolution ? " Chg" : " Charging");
     }
   }
 
@@ -120,7 +159,13 @@ void WatchFaceTerminal::Refresh() {
         hour = hour - 12;
         ampmChar[0] = 'P';
       }
-      lv_label_set_text_fmt(label_time, "[TIME]#11cc55 %02d:%02d:%02d %s#", hour, minute, second, ampmChar);
+      if (lowResolution) {
+        lv_label_set_text_fmt(label_time, "#11cc55 %02d:%02d %s#", hour, minute, ampmChar);
+      } else {
+        lv_label_set_text_fmt(label_time, "[TIME]#11cc55 %02d:%02d:%02d %s#", hour, minute, second, ampmChar);
+      }
+    } else if (lowResolution) {
+      lv_label_set_text_fmt(label_time, "#11cc55 %02d:%02d:%02d", hour, minute, second);
     } else {
       lv_label_set_text_fmt(label_time, "[TIME]#11cc55 %02d:%02d:%02d", hour, minute, second);
     }
@@ -130,7 +175,11 @@ void WatchFaceTerminal::Refresh() {
       uint16_t year = dateTimeController.Year();
       Controllers::DateTime::Months month = dateTimeController.Month();
       uint8_t day = dateTimeController.Day();
-      lv_label_set_text_fmt(label_date, "[DATE]#007fff %04d-%02d-%02d#", short(year), char(month), char(day));
+      if (lowResolution) {
+        lv_label_set_text_fmt(label_date, "#007fff %04d-%02d-%02d#", short(year), char(month), char(day));
+      } else {
+        lv_label_set_text_fmt(label_date, "[DATE]#007fff %04d-%02d-%02d#", short(year), char(month), char(day));
+      }
     }
   }
 
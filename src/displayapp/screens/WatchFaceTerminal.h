@@ -35,6 +35,16 @@ namespace Pinetime {
 
         void Refresh() override;
 
+        bool AllowReducedColorDepth() const override {
+          return true;
+        }
+
+        bool SupportsPixelDoubling() const override {
+          return true;
+        }
+
+        void SetLowResolution(bool enabled) override;
+
       private:
         Utility::DirtyValue<int> batteryPercentRemaining {};
         Utility::DirtyValue<bool> powerPresent {};
@@ -57,6 +67,9 @@ namespace Pinetime {
         lv_obj_t* notificationIcon;
         lv_obj_t* connectState;
 
+        // Laid out for the 120x120 display of the pixel doubling AOD mode
+        bool lowResolution = lv_disp_get_hor_res(nullptr) < LV_HOR_RES_MAX;
+
         Controllers::DateTime& dateTimeController;
         const Controllers::Battery& batteryController;
         const Controllers::Ble& bleController;
@@ -66,6 +79,8 @@ namespace Pinetime {
         Controllers::MotionController& motionController;
 
         lv_task_t* taskRefresh;
+
+        void ApplyLayout();
       };
     }
 
@@ -9,8 +9,12 @@ Spi::Spi(SpiMaster& spiMaster, uint8_t pinCsn) : spiMaster {spiMaster}, pinCsn {
   nrf_gpio_pin_set(pinCsn);
 }
 
-bool Spi::Write(const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook) {
-  return spiMaster.Write(pinCsn, data, size, preTransactionHook);
+bool Spi::Write(const uint8_t* data,
+                size_t size,
+                SpiMaster::PreTransactionPin preTransactionPin,
+                SpiMaster::TransferDoneCallback transferDoneCallback,
+                void* transferDoneContext) {
+  return spiMaster.Write(pinCsn, data, size, preTransactionPin, transferDoneCallback, transferDoneContext);
 }
 
 bool Spi::Read(uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize) {
@@ -26,6 +30,30 @@ bool Spi::WriteCmdAndBuffer(const uint8_t* cmd, size_t cmdSize, const uint8_t* d
   return spiMaster.WriteCmdAndBuffer(pinCsn, cmd, cmdSize, data, dataSize);
 }
 
+void Spi::BeginTransaction() {
+  spiMaster.BeginTransaction(pinCsn);
+}
+
+void Spi::TransmitBursts(const uint8_t* data, size_t size) {
+  spiMaster.TransmitBursts(data, size);
+}
+
+void Spi::ReceiveBursts(uint8_t* data, size_t size) {
+  spiMaster.ReceiveBursts(data, size);
+}
+
+void Spi::EndTransaction() {
+  spiMaster.EndTransaction();
+}
+
+const SpiMaster::TransferStats& Spi::GetTotalTransferStats() const {
+  return spiMaster.GetTotalTransferStats();
+}
+
+void Spi::SetArrayListEnabled(bool enabled) {
+  spiMaster.SetArrayListEnabled(enabled);
+}
+
 bool Spi::Init() {
   nrf_gpio_cfg_output(pinCsn);
   nrf_gpio_pin_set(pinCsn);
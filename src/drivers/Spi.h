@@ -1,7 +1,6 @@
 #pragma once
 #include <cstdint>
 #include <cstddef>
-#include <functional>
 #include "drivers/SpiMaster.h"
 
 namespace Pinetime {
@@ -15,12 +14,24 @@ namespace Pinetime {
       Spi& operator=(Spi&&) = delete;
 
       bool Init();
-      bool Write(const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook);
+      bool Write(const uint8_t* data,
+                 size_t size,
+                 SpiMaster::PreTransactionPin preTransactionPin = {},
+                 SpiMaster::TransferDoneCallback transferDoneCallback = nullptr,
+                 void* transferDoneContext = nullptr);
       bool Read(uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize);
       bool WriteCmdAndBuffer(const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize);
+      void BeginTransaction();
+      void TransmitBursts(const uint8_t* data, size_t size);
+      void ReceiveBursts(uint8_t* data, size_t size);
+      void EndTransaction();
       void Sleep();
       void Wakeup();
 
+      // The statistics and the settings of the SPI master are shared by all the devices of the bus
+      const SpiMaster::TransferStats& GetTotalTransferStats() const;
+      void SetArrayListEnabled(bool enabled);
+
     private:
       SpiMaster& spiMaster;
       uint8_t pinCsn;
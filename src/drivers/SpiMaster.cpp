@@ -90,6 +90,23 @@ bool SpiMaster::Init() {
   NRFX_IRQ_PRIORITY_SET(SPIM0_SPIS0_TWIM0_TWIS0_SPI0_TWI0_IRQn, 2);
   NRFX_IRQ_ENABLE(SPIM0_SPIS0_TWIM0_TWIS0_SPI0_TWI0_IRQn);
 
+  listCounter->TASKS_STOP = 1;
+  listCounter->MODE = TIMER_MODE_MODE_Counter << TIMER_MODE_MODE_Pos;
+  listCounter->BITMODE = TIMER_BITMODE_BITMODE_16Bit << TIMER_BITMODE_BITMODE_Pos;
+  listCounter->INTENCLR = 0xffffffff;
+  nrf_ppi_channel_endpoint_setup(listRestartPpi,
+                                 reinterpret_cast<uint32_t>(&spiBaseAddress->EVENTS_END),
+                                 reinterpret_cast<uint32_t>(&spiBaseAddress->TASKS_START));
+  nrf_ppi_channel_endpoint_setup(listCountPpi,
+                                 reinterpret_cast<uint32_t>(&spiBaseAddress->EVENTS_END),
+                                 reinterpret_cast<uint32_t>(&listCounter->TASKS_COUNT));
+  nrf_ppi_channel_endpoint_setup(listStopPpi,
+                                 reinterpret_cast<uint32_t>(&listCounter->EVENTS_COMPARE[0]),
+                                 reinterpret_cast<uint32_t>(&NRF_PPI->TASKS_CHG[listPpiGroup].DIS));
+  nrf_ppi_channel_include_in_group(listRestartPpi, listPpiGroup);
+  NRFX_IRQ_PRIORITY_SET(TIMER3_IRQn, 2);
+  NRFX_IRQ_ENABLE(TIMER3_IRQn);
+
   xSemaphoreGive(mutex);
   return true;
 }
@@ -140,23 +157,109 @@ void SpiMaster::OnEndEvent() {
     return;
   }
 
+  currentTransferStats.interrupts++;
+  ContinueTransfer();
+}
+
+void SpiMaster::OnListEndEvent() {
+  if (currentBufferAddr == 0) {
+    return;
+  }
+
+  currentTransferStats.interrupts++;
+  StopListTransfer();
+  ContinueTransfer();
+}
+
+void SpiMaster::ContinueTransfer() {
   auto s = currentBufferSize;
   if (s > 0) {
-    auto currentSize = std::min((size_t) 255, s);
+    auto currentSize = std::min(maxChunkSize, s);
     PrepareTx(currentBufferAddr, currentSize);
     currentBufferAddr = currentBufferAddr + currentSize;
     currentBufferSize = currentBufferSize - currentSize;
+    currentTransferStats.chunks++;
 
     spiBaseAddress->TASKS_START = 1;
   } else {
     nrf_gpio_pin_set(this->pinCsn);
     currentBufferAddr = 0;
+    RecordTransferStats();
+    NotifyTransferDone();
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     xSemaphoreGiveFromISR(mutex, &xHigherPriorityTaskWoken);
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
   }
 }
 
+void SpiMaster::RecordTransferStats() {
+  currentTransferStats.cycles = DWT->CYCCNT - transferStartCycles;
+  lastTransferStats = currentTransferStats;
+  totalTransferStats.bytes += currentTransferStats.bytes;
+  totalTransferStats.chunks += currentTransferStats.chunks;
+  totalTransferStats.interrupts += currentTransferStats.interrupts;
+  totalTransferStats.setupCycles += currentTransferStats.setupCycles;
+  totalTransferStats.cycles += currentTransferStats.cycles;
+}
+
+size_t SpiMaster::ListChunkSize(size_t size) {
+  // A chunk size that divides the buffer lets the whole write go out as a single list (e.g. 240 for display bands)
+  for (size_t chunkSize = maxChunkSize; chunkSize >= minListChunkSize; chunkSize--) {
+    if (size % chunkSize == 0) {
+      return chunkSize;
+    }
+  }
+  return maxChunkSize;
+}
+
+void SpiMaster::StartListTransfer(size_t chunkSize, size_t nbChunks) {
+  // Every END restarts the SPIM on the next list entry (TXD.PTR is moved forward by MAXCNT) and increments the counter.
+  // When the counter reaches nbChunks - 1, the restart channel is disabled so the last chunk is not followed by another one,
+  // and the counter raises the only interrupt of the list when the last END is counted.
+  spiBaseAddress->INTENCLR = (1 << 6);
+  spiBaseAddress->INTENCLR = (1 << 19);
+
+  listCounter->TASKS_CLEAR = 1;
+  listCounter->CC[0] = nbChunks - 1;
+  listCounter->CC[1] = nbChunks;
+  listCounter->EVENTS_COMPARE[0] = 0;
+  listCounter->EVENTS_COMPARE[1] = 0;
+  listCounter->INTENSET = TIMER_INTENSET_COMPARE1_Msk;
+  listCounter->TASKS_START = 1;
+
+  nrf_ppi_group_enable(listPpiGroup);
+  nrf_ppi_channel_enable(listCountPpi);
+  nrf_ppi_channel_enable(listStopPpi);
+
+  spiBaseAddress->TXD.PTR = currentBufferAddr;
+  spiBaseAddress->TXD.MAXCNT = chunkSize;
+  spiBaseAddress->TXD.LIST = SPIM_TXD_LIST_LIST_ArrayList << SPIM_TXD_LIST_LIST_Pos;
+  spiBaseAddress->RXD.PTR = 0;
+  spiBaseAddress->RXD.MAXCNT = 0;
+  spiBaseAddress->RXD.LIST = 0;
+  spiBaseAddress->EVENTS_END = 0;
+
+  currentBufferAddr = currentBufferAddr + (chunkSize * nbChunks);
+  currentBufferSize = currentBufferSize - (chunkSize * nbChunks);
+  currentTransferStats.chunks += nbChunks;
+
+  spiBaseAddress->TASKS_START = 1;
+}
+
+void SpiMaster::StopListTransfer() {
+  nrf_ppi_group_disable(listPpiGroup);
+  nrf_ppi_channel_disable(listCountPpi);
+  nrf_ppi_channel_disable(listStopPpi);
+  listCounter->INTENCLR = TIMER_INTENCLR_COMPARE1_Msk;
+  listCounter->TASKS_STOP = 1;
+
+  spiBaseAddress->TXD.LIST = 0;
+  spiBaseAddress->EVENTS_STARTED = 0;
+  spiBaseAddress->EVENTS_END = 0;
+  spiBaseAddress->INTENSET = (1 << 6);
+  spiBaseAddress->INTENSET = (1 << 19);
+}
+
 void SpiMaster::OnStartedEvent() {
 }
 
@@ -180,13 +283,32 @@ void SpiMaster::PrepareRx(const uint32_t bufferAddress, const size_t size) {
   spiBaseAddress->EVENTS_END = 0;
 }
 
-bool SpiMaster::Write(uint8_t pinCsn, const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook) {
+void SpiMaster::NotifyTransferDone() {
+  if (transferDoneCallback != nullptr) {
+    auto callback = transferDoneCallback;
+    transferDoneCallback = nullptr;
+    callback(transferDoneContext);
+  }
+}
+
+bool SpiMaster::Write(uint8_t pinCsn,
+                      const uint8_t* data,
+                      size_t size,
+                      PreTransactionPin preTransactionPin,
+                      TransferDoneCallback transferDoneCallback,
+                      void* transferDoneContext) {
   if (data == nullptr)
     return false;
   auto ok = xSemaphoreTake(mutex, portMAX_DELAY);
   ASSERT(ok == true);
 
+  transferStartCycles = DWT->CYCCNT;
+  currentTransferStats = {};
+  currentTransferStats.bytes = size;
+
   this->pinCsn = pinCsn;
+  this->transferDoneCallback = transferDoneCallback;
+  this->transferDoneContext = transferDoneContext;
 
   if (size == 1) {
     SetupWorkaroundForErratum58();
@@ -194,19 +316,26 @@ bool SpiMaster::Write(uint8_t pinCsn, const uint8_t* data, size_t size, const st
     DisableWorkaroundForErratum58();
   }
 
-  if (preTransactionHook != nullptr) {
-    preTransactionHook();
+  if (preTransactionPin.pin != unusedPin) {
+    nrf_gpio_pin_write(preTransactionPin.pin, preTransactionPin.level ? 1 : 0);
   }
   nrf_gpio_pin_clear(this->pinCsn);
 
   currentBufferAddr = (uint32_t) data;
   currentBufferSize = size;
 
-  auto currentSize = std::min((size_t) 255, (size_t) currentBufferSize);
-  PrepareTx(currentBufferAddr, currentSize);
-  currentBufferSize = currentBufferSize - currentSize;
-  currentBufferAddr = currentBufferAddr + currentSize;
-  spiBaseAddress->TASKS_START = 1;
+  size_t listChunkSize = (arrayListEnabled && size >= 2 * minListChunkSize) ? ListChunkSize(size) : 0;
+  if (listChunkSize > 0 && size / listChunkSize >= 2) {
+    StartListTransfer(listChunkSize, size / listChunkSize);
+  } else {
+    auto currentSize = std::min(maxChunkSize, (size_t) currentBufferSize);
+    PrepareTx(currentBufferAddr, currentSize);
+    currentBufferSize = currentBufferSize - currentSize;
+    currentBufferAddr = currentBufferAddr + currentSize;
+    currentTransferStats.chunks++;
+    spiBaseAddress->TASKS_START = 1;
+  }
+  currentTransferStats.setupCycles = DWT->CYCCNT - transferStartCycles;
 
   if (size == 1) {
     while (spiBaseAddress->EVENTS_END == 0)
@@ -216,6 +345,9 @@ bool SpiMaster::Write(uint8_t pinCsn, const uint8_t* data, size_t size, const st
 
     DisableWorkaroundForErratum58();
 
+    RecordTransferStats();
+
+    NotifyTransferDone();
     xSemaphoreGive(mutex);
   }
 
@@ -223,6 +355,14 @@ bool SpiMaster::Write(uint8_t pinCsn, const uint8_t* data, size_t size, const st
 }
 
 bool SpiMaster::Read(uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize) {
+  BeginTransaction(pinCsn);
+  TransmitBursts(cmd, cmdSize);
+  ReceiveBursts(data, dataSize);
+  EndTransaction();
+  return true;
+}
+
+void SpiMaster::BeginTransaction(uint8_t pinCsn) {
   xSemaphoreTake(mutex, portMAX_DELAY);
 
   this->pinCsn = pinCsn;
@@ -235,22 +375,55 @@ bool SpiMaster::Read(uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data
 
   currentBufferAddr = 0;
   currentBufferSize = 0;
+}
 
-  PrepareTx((uint32_t) cmd, cmdSize);
-  spiBaseAddress->TASKS_START = 1;
-  while (spiBaseAddress->EVENTS_END == 0)
-    ;
+size_t SpiMaster::BurstSize(size_t size) {
+  // Erratum 58: a burst receiving a single byte clocks an extra one, that the slave sends and nobody reads: it would be
+  // missing from the following burst. Large transfers are split without 1 byte remainder (256 bytes = 254 + 2).
+  if (size == maxChunkSize + 1) {
+    return maxChunkSize - 1;
+  }
+  return std::min(size, maxChunkSize);
+}
 
-  PrepareRx((uint32_t) data, dataSize);
-  spiBaseAddress->TASKS_START = 1;
+void SpiMaster::TransmitBursts(const uint8_t* data, size_t size) {
+  while (size > 0) {
+    const size_t burstSize = BurstSize(size);
+    PrepareTx((uint32_t) data, burstSize);
+    spiBaseAddress->TASKS_START = 1;
+    while (spiBaseAddress->EVENTS_END == 0)
+      ;
+    data += burstSize;
+    size -= burstSize;
+  }
+}
 
-  while (spiBaseAddress->EVENTS_END == 0)
-    ;
-  nrf_gpio_pin_set(this->pinCsn);
+void SpiMaster::ReceiveBursts(uint8_t* data, size_t size) {
+  while (size > 0) {
+    const size_t burstSize = BurstSize(size);
+    // Only a caller asking for a single byte gets a 1 byte burst, which is stopped after its first byte (erratum 58)
+    if (burstSize == 1) {
+      SetupWorkaroundForErratum58();
+    }
+    PrepareRx((uint32_t) data, burstSize);
+    spiBaseAddress->TASKS_START = 1;
+    while (spiBaseAddress->EVENTS_END == 0)
+      ;
+    if (burstSize == 1) {
+      DisableWorkaroundForErratum58();
+      // The transaction polls the END event, the interrupt handler would clear it
+      spiBaseAddress->INTENCLR = (1 << 6);
+      spiBaseAddress->INTENCLR = (1 << 1);
+      spiBaseAddress->INTENCLR = (1 << 19);
+    }
+    data += burstSize;
+    size -= burstSize;
+  }
+}
 
+void SpiMaster::EndTransaction() {
+  nrf_gpio_pin_set(this->pinCsn);
   xSemaphoreGive(mutex);
-
-  return true;
 }
 
 void SpiMaster::Sleep() {
@@ -270,32 +443,9 @@ void SpiMaster::Wakeup() {
 }
 
 bool SpiMaster::WriteCmdAndBuffer(uint8_t pinCsn, const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize) {
-  xSemaphoreTake(mutex, portMAX_DELAY);
-
-  this->pinCsn = pinCsn;
-  DisableWorkaroundForErratum58();
-  spiBaseAddress->INTENCLR = (1 << 6);
-  spiBaseAddress->INTENCLR = (1 << 1);
-  spiBaseAddress->INTENCLR = (1 << 19);
-
-  nrf_gpio_pin_clear(this->pinCsn);
-
-  currentBufferAddr = 0;
-  currentBufferSize = 0;
-
-  PrepareTx((uint32_t) cmd, cmdSize);
-  spiBaseAddress->TASKS_START = 1;
-  while (spiBaseAddress->EVENTS_END == 0)
-    ;
-
-  PrepareTx((uint32_t) data, dataSize);
-  spiBaseAddress->TASKS_START = 1;
-
-  while (spiBaseAddress->EVENTS_END == 0)
-    ;
-  nrf_gpio_pin_set(this->pinCsn);
-
-  xSemaphoreGive(mutex);
-
+  BeginTransaction(pinCsn);
+  TransmitBursts(cmd, cmdSize);
+  TransmitBursts(data, dataSize);
+  EndTransaction();
   return true;
 }
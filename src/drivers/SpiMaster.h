@@ -1,7 +1,6 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
-#include <functional>
 
 #include <FreeRTOS.h>
 #include <semphr.h>
@@ -17,6 +16,24 @@ namespace Pinetime {
       enum class BitOrder : uint8_t { Msb_Lsb, Lsb_Msb };
       enum class Modes : uint8_t { Mode0, Mode1, Mode2, Mode3 };
       enum class Frequencies : uint8_t { Freq8Mhz };
+      // Called once the last byte of a transfer has been clocked out, from the SPIM interrupt handler
+      using TransferDoneCallback = void (*)(void* context);
+
+      static constexpr uint8_t unusedPin = 0xff;
+
+      // GPIO driven to the given level right before chip select is asserted (e.g. the data/command line of the display)
+      struct PreTransactionPin {
+        uint8_t pin = unusedPin;
+        bool level = false;
+      };
+
+      struct TransferStats {
+        uint32_t bytes = 0;
+        uint32_t chunks = 0;      // EasyDMA transactions
+        uint32_t interrupts = 0;  // SPIM and list counter interrupts serviced
+        uint32_t setupCycles = 0; // CPU cycles from the acquisition of the bus to the start of the first DMA transaction
+        uint32_t cycles = 0;      // CPU cycles from the acquisition of the bus to the completion of the write
+      };
 
       struct Parameters {
         BitOrder bitOrder;
@@ -34,13 +51,39 @@ namespace Pinetime {
       SpiMaster& operator=(SpiMaster&&) = delete;
 
       bool Init();
-      bool Write(uint8_t pinCsn, const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook);
+      bool Write(uint8_t pinCsn,
+                 const uint8_t* data,
+                 size_t size,
+                 PreTransactionPin preTransactionPin = PreTransactionPin {unusedPin, false},
+                 TransferDoneCallback transferDoneCallback = nullptr,
+                 void* transferDoneContext = nullptr);
       bool Read(uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize);
 
       bool WriteCmdAndBuffer(uint8_t pinCsn, const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize);
 
+      // Blocking transfers of any size sharing a single chip select assertion, split in EasyDMA sized bursts.
+      // The bus is owned by the caller between BeginTransaction() and EndTransaction().
+      void BeginTransaction(uint8_t pinCsn);
+      void TransmitBursts(const uint8_t* data, size_t size);
+      void ReceiveBursts(uint8_t* data, size_t size);
+      void EndTransaction();
+
       void OnStartedEvent();
       void OnEndEvent();
+      void OnListEndEvent();
+
+      // Chain the EasyDMA chunks of large writes in hardware (array list + PPI) instead of from the END interrupt
+      void SetArrayListEnabled(bool enabled) {
+        arrayListEnabled = enabled;
+      }
+
+      const TransferStats& GetLastTransferStats() const {
+        return lastTransferStats;
+      }
+
+      const TransferStats& GetTotalTransferStats() const {
+        return totalTransferStats;
+      }
 
       void Sleep();
       void Wakeup();
@@ -50,6 +93,13 @@ namespace Pinetime {
       void DisableWorkaroundForErratum58();
       void PrepareTx(const volatile uint32_t bufferAddress, const volatile size_t size);
       void PrepareRx(const volatile uint32_t bufferAddress, const volatile size_t size);
+      void NotifyTransferDone();
+      void ContinueTransfer();
+      void StartListTransfer(size_t chunkSize, size_t nbChunks);
+      void StopListTransfer();
+      void RecordTransferStats();
+      static size_t ListChunkSize(size_t size);
+      static size_t BurstSize(size_t size);
 
       NRF_SPIM_Type* spiBaseAddress;
       uint8_t pinCsn;
@@ -59,9 +109,26 @@ namespace Pinetime {
 
       volatile uint32_t currentBufferAddr = 0;
       volatile size_t currentBufferSize = 0;
+      TransferDoneCallback transferDoneCallback = nullptr;
+      void* transferDoneContext = nullptr;
       SemaphoreHandle_t mutex = nullptr;
       static constexpr nrf_ppi_channel_t workaroundPpi = NRF_PPI_CHANNEL0;
       bool workaroundActive = false;
+
+      static constexpr size_t maxChunkSize = 255;
+      static constexpr size_t minListChunkSize = 128;
+      // END -> START (member of listPpiGroup), END -> counter COUNT, counter COMPARE[0] -> listPpiGroup DIS
+      static constexpr nrf_ppi_channel_t listRestartPpi = NRF_PPI_CHANNEL6;
+      static constexpr nrf_ppi_channel_t listCountPpi = NRF_PPI_CHANNEL7;
+      static constexpr nrf_ppi_channel_t listStopPpi = NRF_PPI_CHANNEL8;
+      static constexpr nrf_ppi_channel_group_t listPpiGroup = NRF_PPI_CHANNEL_GROUP0;
+      NRF_TIMER_Type* const listCounter = NRF_TIMER3;
+      bool arrayListEnabled = true;
+
+      TransferStats currentTransferStats;
+      TransferStats lastTransferStats;
+      TransferStats totalTransferStats;
+      uint32_t transferStartCycles = 0;
     };
   }
 }
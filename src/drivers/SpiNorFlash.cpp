@@ -1,12 +1,25 @@
 #include "drivers/SpiNorFlash.h"
+#include <algorithm>
 #include <hal/nrf_gpio.h>
 #include <libraries/delay/nrf_delay.h>
 #include <libraries/log/nrf_log.h>
 #include "drivers/Spi.h"
+#include "nrf_assert.h"
+#include "utility/ElapsedTime.h"
 
 using namespace Pinetime::Drivers;
 
 SpiNorFlash::SpiNorFlash(Spi& spi) : spi {spi} {
+  mutex = xSemaphoreCreateRecursiveMutex();
+  ASSERT(mutex != nullptr);
+}
+
+SpiNorFlash::Lock::Lock(SpiNorFlash& flash) : flash {flash} {
+  xSemaphoreTakeRecursive(flash.mutex, portMAX_DELAY);
+}
+
+SpiNorFlash::Lock::~Lock() {
+  xSemaphoreGiveRecursive(flash.mutex);
 }
 
 void SpiNorFlash::Init() {
@@ -15,14 +28,20 @@ void SpiNorFlash::Init() {
                device_id.manufacturer,
                device_id.type,
                device_id.density);
+#ifdef SPINORFLASH_BENCHMARK
+  RunReadBenchmark();
+#endif
 }
 
 void SpiNorFlash::Uninit() {
 }
 
 void SpiNorFlash::Sleep() {
+  Lock lock(*this);
+  WaitReady();
   auto cmd = static_cast<uint8_t>(Commands::DeepPowerDown);
-  spi.Write(&cmd, sizeof(uint8_t), nullptr);
+  spi.Write(&cmd, sizeof(uint8_t));
+  sleeping = true;
   NRF_LOG_INFO("[SpiNorFlash] Sleep")
 }
 
@@ -31,7 +50,9 @@ void SpiNorFlash::Wakeup() {
   static constexpr uint8_t cmdSize = 4;
   uint8_t cmd[cmdSize] = {static_cast<uint8_t>(Commands::ReleaseFromDeepPowerDown), 0x01, 0x02, 0x03};
   uint8_t id = 0;
+  Lock lock(*this);
   spi.Read(reinterpret_cast<uint8_t*>(&cmd), cmdSize, &id, 1);
+  sleeping = false;
   auto devId = device_id = ReadIdentification();
   if (devId.type != device_id.type) {
     NRF_LOG_INFO("[SpiNorFlash] ID on Wakeup: Failed");
@@ -70,13 +91,53 @@ uint8_t SpiNorFlash::ReadConfigurationRegister() {
   return status;
 }
 
+void SpiNorFlash::PrepareFastRead(uint8_t* cmd, uint32_t address) {
+  cmd[0] = static_cast<uint8_t>(Commands::FastRead);
+  cmd[1] = static_cast<uint8_t>(address >> 16U);
+  cmd[2] = static_cast<uint8_t>(address >> 8U);
+  cmd[3] = static_cast<uint8_t>(address);
+  cmd[4] = 0; // dummy
+}
+
 void SpiNorFlash::Read(uint32_t address, uint8_t* buffer, size_t size) {
-  static constexpr uint8_t cmdSize = 4;
-  uint8_t cmd[cmdSize] = {static_cast<uint8_t>(Commands::Read),
-                          static_cast<uint8_t>(address >> 16U),
-                          static_cast<uint8_t>(address >> 8U),
-                          static_cast<uint8_t>(address)};
-  spi.Read(reinterpret_cast<uint8_t*>(&cmd), cmdSize, buffer, size);
+  Lock lock(*this);
+  if (sleeping) {
+    return;
+  }
+  WaitReady();
+  uint8_t cmd[fastReadCmdSize];
+  PrepareFastRead(cmd, address);
+  spi.Read(cmd, fastReadCmdSize, buffer, size);
+}
+
+void SpiNorFlash::ReadStream(
+  uint32_t address, size_t size, uint8_t* buffer, size_t bufferSize, ReadStreamConsumer consumer, void* context) {
+  while (size > 0) {
+    const size_t sessionSize = std::min(size, streamSessionSize);
+    uint8_t cmd[fastReadCmdSize];
+    PrepareFastRead(cmd, address);
+
+    // Another task may have started a program or an erase since the previous session
+    Lock lock(*this);
+    if (sleeping) {
+      return;
+    }
+    WaitReady();
+    spi.BeginTransaction();
+    spi.TransmitBursts(cmd, fastReadCmdSize);
+    // The SPI master splits each chunk in bursts that never receive a single byte in the middle of the stream
+    // (erratum 58 would drop the next byte): a 256 bytes buffer is read in 254 + 2 bytes
+    for (size_t done = 0; done < sessionSize;) {
+      const size_t chunkSize = std::min(bufferSize, sessionSize - done);
+      spi.ReceiveBursts(buffer, chunkSize);
+      consumer(context, buffer, chunkSize);
+      done += chunkSize;
+    }
+    spi.EndTransaction();
+
+    address += sessionSize;
+    size -= sessionSize;
+  }
 }
 
 void SpiNorFlash::WriteEnable() {
@@ -85,23 +146,86 @@ void SpiNorFlash::WriteEnable() {
 }
 
 void SpiNorFlash::SectorErase(uint32_t sectorAddress) {
+  Lock lock(*this);
+  BeginSectorErase(sectorAddress);
+  WaitReady();
+}
+
+void SpiNorFlash::BeginSectorErase(uint32_t sectorAddress) {
+  Lock lock(*this);
+  StartOperation(Operations::SectorErase, Commands::SectorErase, sectorAddress, nullptr, 0);
+  writeStatistics.sectorsErased++;
+}
+
+void SpiNorFlash::StartOperation(Operations operation, Commands command, uint32_t address, const uint8_t* data, size_t size) {
   static constexpr uint8_t cmdSize = 4;
-  uint8_t cmd[cmdSize] = {static_cast<uint8_t>(Commands::SectorErase),
-                          static_cast<uint8_t>(sectorAddress >> 16U),
-                          static_cast<uint8_t>(sectorAddress >> 8U),
-                          static_cast<uint8_t>(sectorAddress)};
+  uint8_t cmd[cmdSize] = {static_cast<uint8_t>(command),
+                          static_cast<uint8_t>(address >> 16U),
+                          static_cast<uint8_t>(address >> 8U),
+                          static_cast<uint8_t>(address)};
 
+  Lock lock(*this);
+  // The write enable would never be acknowledged
+  if (sleeping) {
+    return;
+  }
+  WaitReady();
   WriteEnable();
   while (!WriteEnabled())
     vTaskDelay(1);
 
-  spi.Read(reinterpret_cast<uint8_t*>(&cmd), cmdSize, nullptr, 0);
+  // The flash is busy as soon as the command ends
+  pendingOperation = operation;
+  pendingOperationStart = xTaskGetTickCount();
+  pendingOperationSize = size;
+  spi.WriteCmdAndBuffer(cmd, cmdSize, data, size);
+}
 
-  while (WriteInProgress())
-    vTaskDelay(1);
+void SpiNorFlash::WaitReady() {
+  Lock lock(*this);
+  if (pendingOperation == Operations::None) {
+    return;
+  }
+
+  const Utility::ElapsedTime blocked;
+  if (pendingOperation == Operations::SectorErase) {
+    const TickType_t elapsed = xTaskGetTickCount() - pendingOperationStart;
+    if (elapsed < sectorEraseTime) {
+      vTaskDelay(sectorEraseTime - elapsed);
+    }
+    while (WriteInProgress())
+      vTaskDelay(1);
+  } else if (pendingOperationSize <= shortProgramSize) {
+    uint32_t polledTime = 0;
+    while (WriteInProgress()) {
+      if (polledTime < shortProgramMaxTime) {
+        nrf_delay_us(shortProgramPollInterval);
+        polledTime += shortProgramPollInterval;
+      } else {
+        vTaskDelay(1);
+      }
+    }
+  } else {
+    while (WriteInProgress()) {
+      vTaskDelay(1);
+    }
+  }
+  const Operations completed = pendingOperation;
+  pendingOperation = Operations::None;
+  writeStatistics.blockedTime += blocked.Microseconds();
+
+  // The failure flags only describe the last program or erase: they are read before another one can start
+  const uint8_t securityRegister = ReadSecurityRegister();
+  if (completed == Operations::PageProgram && (securityRegister & programFailedFlag) != 0) {
+    writeStatistics.programFailures++;
+  } else if (completed == Operations::SectorErase && (securityRegister & eraseFailedFlag) != 0) {
+    writeStatistics.eraseFailures++;
+  }
 }
 
 uint8_t SpiNorFlash::ReadSecurityRegister() {
+  Lock lock(*this);
+  WaitReady();
   auto cmd = static_cast<uint8_t>(Commands::ReadSecurityRegister);
   uint8_t status;
   spi.Read(&cmd, sizeof(cmd), &status, sizeof(uint8_t));
@@ -109,16 +233,15 @@ uint8_t SpiNorFlash::ReadSecurityRegister() {
 }
 
 bool SpiNorFlash::ProgramFailed() {
-  return (ReadSecurityRegister() & 0x20u) == 0x20u;
+  return (ReadSecurityRegister() & programFailedFlag) == programFailedFlag;
 }
 
 bool SpiNorFlash::EraseFailed() {
-  return (ReadSecurityRegister() & 0x40u) == 0x40u;
+  return (ReadSecurityRegister() & eraseFailedFlag) == eraseFailedFlag;
 }
 
 void SpiNorFlash::Write(uint32_t address, const uint8_t* buffer, size_t size) {
-  static constexpr uint8_t cmdSize = 4;
-
+  Lock lock(*this);
   size_t len = size;
   uint32_t addr = address;
   const uint8_t* b = buffer;
@@ -126,19 +249,8 @@ void SpiNorFlash::Write(uint32_t address, const uint8_t* buffer, size_t size) {
     uint32_t pageLimit = (addr & ~(pageSize - 1u)) + pageSize;
     uint32_t toWrite = pageLimit - addr > len ? len : pageLimit - addr;
 
-    uint8_t cmd[cmdSize] = {static_cast<uint8_t>(Commands::PageProgram),
-                            static_cast<uint8_t>(addr >> 16U),
-                            static_cast<uint8_t>(addr >> 8U),
-                            static_cast<uint8_t>(addr)};
-
-    WriteEnable();
-    while (!WriteEnabled())
-      vTaskDelay(1);
-
-    spi.WriteCmdAndBuffer(cmd, cmdSize, b, toWrite);
-
-    while (WriteInProgress())
-      vTaskDelay(1);
+    StartOperation(Operations::PageProgram, Commands::PageProgram, addr, b, toWrite);
+    writeStatistics.bytesProgrammed += toWrite;
 
     addr += toWrite;
     b += toWrite;
@@ -149,3 +261,44 @@ void SpiNorFlash::Write(uint32_t address, const uint8_t* buffer, size_t size) {
 SpiNorFlash::Identification SpiNorFlash::GetIdentification() const {
   return device_id;
 }
+
+#ifdef SPINORFLASH_BENCHMARK
+namespace {
+  void LogReadThroughput(const char* kind, size_t size, const Pinetime::Utility::ElapsedTime& duration) {
+    const uint64_t microseconds = std::max<uint32_t>(duration.Microseconds(), 1);
+    const uint32_t kbPerSecond = static_cast<uint32_t>((static_cast<uint64_t>(size) * 1000000u) / (microseconds * 1024u));
+    NRF_LOG_INFO("[SpiNorFlash] %s: %lu KB/s", kind, kbPerSecond);
+  }
+
+  void DiscardStream(void* /*context*/, const uint8_t* /*data*/, size_t /*size*/) {
+  }
+}
+
+void SpiNorFlash::RunReadBenchmark() {
+  // Reads only, from the start of the file system
+  static constexpr uint32_t address = 0x0B4000;
+  static constexpr size_t totalSize = 64 * 1024;
+  static constexpr size_t smallReadSize = 16;
+  uint8_t buffer[pageSize];
+
+  {
+    const Utility::ElapsedTime duration;
+    for (size_t offset = 0; offset < totalSize; offset += smallReadSize) {
+      Read(address + offset, buffer, smallReadSize);
+    }
+    LogReadThroughput("16 B reads", totalSize, duration);
+  }
+
+  {
+    const Utility::ElapsedTime duration;
+    for (size_t offset = 0; offset < totalSize; offset += sizeof(buffer)) {
+      Read(address + offset, buffer, sizeof(buffer));
+    }
+    LogReadThroughput("256 B reads", totalSize, duration);
+  }
+
+  const Utility::ElapsedTime duration;
+  ReadStream(address, totalSize, buffer, sizeof(buffer), DiscardStream, nullptr);
+  LogReadThroughput("stream", totalSize, duration);
+}
+#endif
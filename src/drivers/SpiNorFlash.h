@@ -1,11 +1,15 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
+#include <FreeRTOS.h>
+#include <semphr.h>
 
 namespace Pinetime {
   namespace Drivers {
     class Spi;
 
+    // The driver is used by several tasks (file system users, DFU in the BLE host task): the command sequences and the
+    // state of the pending program or erase are protected by a recursive mutex.
     class SpiNorFlash {
     public:
       explicit SpiNorFlash(Spi& spi);
@@ -14,6 +18,18 @@ namespace Pinetime {
       SpiNorFlash(SpiNorFlash&&) = delete;
       SpiNorFlash& operator=(SpiNorFlash&&) = delete;
 
+      // Called with the data read by ReadStream(), while the SPI bus is held: it must not use the bus
+      using ReadStreamConsumer = void (*)(void* context, const uint8_t* data, size_t size);
+
+      struct WriteStatistics {
+        uint32_t bytesProgrammed = 0;
+        uint32_t sectorsErased = 0;
+        uint32_t blockedTime = 0; // us spent by the callers waiting for a program or an erase to complete
+        // Operations the flash reported as failed, checked when each of them completes
+        uint32_t programFailures = 0;
+        uint32_t eraseFailures = 0;
+      };
+
       struct __attribute__((packed)) Identification {
         uint8_t manufacturer = 0;
         uint8_t type = 0;
@@ -25,27 +41,49 @@ namespace Pinetime {
       bool WriteEnabled();
       uint8_t ReadConfigurationRegister();
       void Read(uint32_t address, uint8_t* buffer, size_t size);
+      // Sequential read of a large area through a small buffer, the read command is sent once per streamSessionSize bytes
+      void ReadStream(uint32_t address, size_t size, uint8_t* buffer, size_t bufferSize, ReadStreamConsumer consumer, void* context);
+      // Returns once the last page program has been started, the next operation waits for its completion
       void Write(uint32_t address, const uint8_t* buffer, size_t size);
       void WriteEnable();
       void SectorErase(uint32_t sectorAddress);
+      // Starts the erase and returns, the next operation waits for its completion
+      void BeginSectorErase(uint32_t sectorAddress);
+      // Waits for the completion of the pending program or erase, if any
+      void WaitReady();
       uint8_t ReadSecurityRegister();
       bool ProgramFailed();
       bool EraseFailed();
 
       Identification GetIdentification() const;
 
+      const WriteStatistics& GetWriteStatistics() const {
+        return writeStatistics;
+      }
+
       void Init();
       void Uninit();
 
+      // In deep power-down the flash ignores every command but the release: until Wakeup(), reads, programs and erases
+      // return without using the bus
       void Sleep();
       void Wakeup();
 
+      bool IsSleeping() const {
+        return sleeping;
+      }
+
     private:
       Identification ReadIdentification();
+      static void PrepareFastRead(uint8_t* cmd, uint32_t address);
+#ifdef SPINORFLASH_BENCHMARK
+      void RunReadBenchmark();
+#endif
 
       enum class Commands : uint8_t {
         PageProgram = 0x02,
         Read = 0x03,
+        FastRead = 0x0B,
         ReadStatusRegister = 0x05,
         WriteEnable = 0x06,
         ReadConfigurationRegister = 0x15,
@@ -55,7 +93,44 @@ namespace Pinetime {
         ReleaseFromDeepPowerDown = 0xAB,
         DeepPowerDown = 0xB9
       };
+      enum class Operations : uint8_t { None, PageProgram, SectorErase };
+
+      void StartOperation(Operations operation, Commands command, uint32_t address, const uint8_t* data, size_t size);
+
+      class Lock {
+      public:
+        explicit Lock(SpiNorFlash& flash);
+        ~Lock();
+        Lock(const Lock&) = delete;
+        Lock& operator=(const Lock&) = delete;
+
+      private:
+        SpiNorFlash& flash;
+      };
+
       static constexpr uint16_t pageSize = 256;
+      // Security register
+      static constexpr uint8_t programFailedFlag = 0x20;
+      static constexpr uint8_t eraseFailedFlag = 0x40;
+      // Fast Read: command, 24 bits address and a dummy byte
+      static constexpr uint8_t fastReadCmdSize = 5;
+      // Amount of data read by ReadStream() before the bus is released to the other devices (display)
+      static constexpr size_t streamSessionSize = 4096;
+      // A sector erase (typically 50 ms) sleeps until its typical duration has elapsed before polling the status once per tick.
+      // A program of a few bytes (the 16 bytes caches of littlefs in its small RAM profile) takes tens of us, a tick
+      // would cost 20 times its duration: it is polled every 10 us, up to shortProgramMaxTime. Longer programs, up to a
+      // whole page (typically 600 us), let the other tasks run and poll once per tick.
+      static constexpr TickType_t sectorEraseTime = pdMS_TO_TICKS(50);
+      static constexpr size_t shortProgramSize = 16;
+      static constexpr uint32_t shortProgramPollInterval = 10;
+      static constexpr uint32_t shortProgramMaxTime = 300;
+
+      SemaphoreHandle_t mutex = nullptr;
+      Operations pendingOperation = Operations::None;
+      TickType_t pendingOperationStart = 0;
+      size_t pendingOperationSize = 0;
+      bool sleeping = false;
+      WriteStatistics writeStatistics;
 
       Spi& spi;
       Identification device_id;
@@ -4,6 +4,9 @@
 #include <nrfx_log.h>
 #include "drivers/Spi.h"
 #include "task.h"
+#ifdef LVGL_FRAME_BENCHMARK
+  #include <functional>
+#endif
 
 using namespace Pinetime::Drivers;
 
@@ -40,9 +43,7 @@ void St7789::WriteData(uint8_t data) {
 }
 
 void St7789::WriteData(const uint8_t* data, size_t size) {
-  WriteSpi(data, size, [pinDataCommand = pinDataCommand]() {
-    nrf_gpio_pin_set(pinDataCommand);
-  });
+  WriteSpi(data, size, true);
 }
 
 void St7789::WriteCommand(uint8_t data) {
@@ -50,18 +51,22 @@ void St7789::WriteCommand(uint8_t data) {
 }
 
 void St7789::WriteCommand(const uint8_t* data, size_t size) {
-  WriteSpi(data, size, [pinDataCommand = pinDataCommand]() {
-    nrf_gpio_pin_clear(pinDataCommand);
-  });
+  WriteSpi(data, size, false);
 }
 
-void St7789::WriteSpi(const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook) {
-  spi.Write(data, size, preTransactionHook);
+void St7789::WriteSpi(const uint8_t* data,
+                      size_t size,
+                      bool isData,
+                      SpiMaster::TransferDoneCallback transferDoneCallback,
+                      void* transferDoneContext) {
+  // The data/command line is driven by SpiMaster right before chip select, no callable is needed per transaction
+  spi.Write(data, size, {pinDataCommand, isData}, transferDoneCallback, transferDoneContext);
 }
 
 void St7789::SoftwareReset() {
   EnsureSleepOutPostDelay();
   WriteCommand(static_cast<uint8_t>(Commands::SoftwareReset));
+  InvalidateAddressWindow();
   // If sleep in: must wait 120ms before sleep out can sent (see driver datasheet)
   // Unconditionally wait as software reset doesn't need to be performant
   sleepIn = true;
@@ -116,8 +121,16 @@ void St7789::SleepIn() {
 
 void St7789::PixelFormat() {
   WriteCommand(static_cast<uint8_t>(Commands::PixelFormat));
-  // 65K colours, 16-bit per pixel
-  WriteData(0x55);
+  WriteData(static_cast<uint8_t>(pixelFormat));
+}
+
+void St7789::SetPixelFormat(PixelFormats format) {
+  if (format == pixelFormat) {
+    return;
+  }
+  // The frame memory keeps its content, only the interface format changes
+  pixelFormat = format;
+  PixelFormat();
 }
 
 void St7789::MemoryDataAccessControl() {
@@ -217,29 +230,44 @@ void St7789::GateControl() {
 }
 
 void St7789::SetAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
-  WriteCommand(static_cast<uint8_t>(Commands::ColumnAddressSet));
-  uint8_t colArgs[] = {
-    static_cast<uint8_t>(x0 >> 8), // x start MSB
-    static_cast<uint8_t>(x0),      // x start LSB
-    static_cast<uint8_t>(x1 >> 8), // x end MSB
-    static_cast<uint8_t>(x1)       // x end LSB
-  };
-  WriteData(colArgs, sizeof(colArgs));
-
-  WriteCommand(static_cast<uint8_t>(Commands::RowAddressSet));
-  uint8_t rowArgs[] = {
-    static_cast<uint8_t>(y0 >> 8), // y start MSB
-    static_cast<uint8_t>(y0),      // y start LSB
-    static_cast<uint8_t>(y1 >> 8), // y end MSB
-    static_cast<uint8_t>(y1)       // y end LSB
-  };
-  memcpy(addrWindowArgs, rowArgs, sizeof(rowArgs));
-  WriteData(addrWindowArgs, sizeof(addrWindowArgs));
+  // Consecutive bands of the same area share their columns, the controller keeps them until they change
+  if (x0 != columnStart || x1 != columnEnd) {
+    WriteCommand(static_cast<uint8_t>(Commands::ColumnAddressSet));
+    uint8_t colArgs[] = {
+      static_cast<uint8_t>(x0 >> 8), // x start MSB
+      static_cast<uint8_t>(x0),      // x start LSB
+      static_cast<uint8_t>(x1 >> 8), // x end MSB
+      static_cast<uint8_t>(x1)       // x end LSB
+    };
+    // Might be the last transfer before returning if the rows are unchanged, it must not be sent from the stack
+    memcpy(addrColumnArgs, colArgs, sizeof(colArgs));
+    WriteData(addrColumnArgs, sizeof(addrColumnArgs));
+    columnStart = x0;
+    columnEnd = x1;
+  }
+
+  // Column strips (horizontal transitions) share their rows in the same way
+  if (y0 != rowStart || y1 != rowEnd) {
+    WriteCommand(static_cast<uint8_t>(Commands::RowAddressSet));
+    uint8_t rowArgs[] = {
+      static_cast<uint8_t>(y0 >> 8), // y start MSB
+      static_cast<uint8_t>(y0),      // y start LSB
+      static_cast<uint8_t>(y1 >> 8), // y end MSB
+      static_cast<uint8_t>(y1)       // y end LSB
+    };
+    memcpy(addrWindowArgs, rowArgs, sizeof(rowArgs));
+    WriteData(addrWindowArgs, sizeof(addrWindowArgs));
+    rowStart = y0;
+    rowEnd = y1;
+  }
 }
 
-void St7789::WriteToRam(const uint8_t* data, size_t size) {
+void St7789::WriteToRam(const uint8_t* data,
+                        size_t size,
+                        SpiMaster::TransferDoneCallback transferDoneCallback,
+                        void* transferDoneContext) {
   WriteCommand(static_cast<uint8_t>(Commands::WriteToRam));
-  WriteData(data, size);
+  WriteSpi(data, size, true, transferDoneCallback, transferDoneContext);
 }
 
 void St7789::SetVdv() {
@@ -267,15 +295,30 @@ void St7789::VerticalScrollStartAddress(uint16_t line) {
 void St7789::Uninit() {
 }
 
-void St7789::DrawBuffer(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* data, size_t size) {
+void St7789::DrawBuffer(uint16_t x,
+                        uint16_t y,
+                        uint16_t width,
+                        uint16_t height,
+                        const uint8_t* data,
+                        size_t size,
+                        SpiMaster::TransferDoneCallback transferDoneCallback,
+                        void* transferDoneContext) {
   SetAddrWindow(x, y, x + width - 1, y + height - 1);
-  WriteToRam(data, size);
+  WriteToRam(data, size, transferDoneCallback, transferDoneContext);
+}
+
+void St7789::InvalidateAddressWindow() {
+  columnStart = invalidAddress;
+  columnEnd = invalidAddress;
+  rowStart = invalidAddress;
+  rowEnd = invalidAddress;
 }
 
 void St7789::HardwareReset() {
   nrf_gpio_pin_clear(pinReset);
   vTaskDelay(pdMS_TO_TICKS(1));
   nrf_gpio_pin_set(pinReset);
+  InvalidateAddressWindow();
   // If hardware reset started while sleep out, reset time may be up to 120ms
   // Unconditionally wait as hardware reset doesn't need to be performant
   sleepIn = true;
@@ -301,6 +344,57 @@ void St7789::Sleep() {
   NRF_LOG_INFO("[LCD] Sleep");
 }
 
+const SpiMaster::TransferStats& St7789::GetTransferStats() const {
+  return spi.GetTotalTransferStats();
+}
+
+void St7789::SetArrayListEnabled(bool enabled) {
+  spi.SetArrayListEnabled(enabled);
+}
+
+#ifdef LVGL_FRAME_BENCHMARK
+namespace {
+  // Out of line, like the hooks passed down Spi::Write() to SpiMaster::Write()
+  __attribute__((noinline)) void RunFunctionHook(const std::function<void()>& preTransactionHook) {
+    if (preTransactionHook != nullptr) {
+      preTransactionHook();
+    }
+  }
+
+  __attribute__((noinline)) void RunPinHook(SpiMaster::PreTransactionPin preTransactionPin) {
+    if (preTransactionPin.pin != SpiMaster::unusedPin) {
+      nrf_gpio_pin_write(preTransactionPin.pin, preTransactionPin.level ? 1 : 0);
+    }
+  }
+}
+
+void St7789::LogPreTransactionHookCost() {
+  static constexpr uint32_t iterations = 1000;
+  // SetAddrWindow() and WriteToRam(): a command and its data for the columns, the rows and the pixels
+  static constexpr uint32_t writesPerArea = 6;
+
+  uint32_t start = DWT->CYCCNT;
+  for (uint32_t i = 0; i < iterations; i++) {
+    // The lambda built for each write by WriteData() and WriteCommand()
+    RunFunctionHook([this]() {
+      nrf_gpio_pin_set(pinDataCommand);
+    });
+  }
+  const uint32_t functionCycles = (DWT->CYCCNT - start) / iterations;
+
+  start = DWT->CYCCNT;
+  for (uint32_t i = 0; i < iterations; i++) {
+    RunPinHook({pinDataCommand, true});
+  }
+  const uint32_t pinCycles = (DWT->CYCCNT - start) / iterations;
+
+  NRF_LOG_INFO("[Frame cost] data/command hook per SPI write: std::function %lu cycles, pin %lu cycles, %ld cycles saved per area",
+               functionCycles,
+               pinCycles,
+               static_cast<int32_t>((functionCycles - pinCycles) * writesPerArea));
+}
+#endif
+
 void St7789::Wakeup() {
   nrf_gpio_cfg_output(pinDataCommand);
   SleepOut();
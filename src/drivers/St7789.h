@@ -1,9 +1,9 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
-#include <functional>
 
 #include <FreeRTOS.h>
+#include "drivers/SpiMaster.h"
 
 namespace Pinetime {
   namespace Drivers {
@@ -20,9 +20,37 @@ namespace Pinetime {
       void Init();
       void Uninit();
 
+      enum class PixelFormats : uint8_t {
+        Rgb444 = 0x53, // 4K colours, 2 pixels packed in 3 bytes
+        Rgb565 = 0x55, // 65K colours, 16-bit per pixel
+      };
+
       void VerticalScrollStartAddress(uint16_t line);
+      void SetPixelFormat(PixelFormats format);
+
+      PixelFormats GetPixelFormat() const {
+        return pixelFormat;
+      }
+
+      // Returns as soon as the pixel transfer is started: the buffer must stay untouched until transferDoneCallback is called
+      void DrawBuffer(uint16_t x,
+                      uint16_t y,
+                      uint16_t width,
+                      uint16_t height,
+                      const uint8_t* data,
+                      size_t size,
+                      SpiMaster::TransferDoneCallback transferDoneCallback = nullptr,
+                      void* transferDoneContext = nullptr);
+
+      // Transfers of the SPI bus the display is on, and how their EasyDMA chunks are chained (see SpiMaster)
+      const SpiMaster::TransferStats& GetTransferStats() const;
+      void SetArrayListEnabled(bool enabled);
 
-      void DrawBuffer(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* data, size_t size);
+#ifdef LVGL_FRAME_BENCHMARK
+      // Cycles spent driving the data/command line of a SPI write, with the std::function hook it used to take and with
+      // the pin descriptor that replaced it
+      void LogPreTransactionHookCost();
+#endif
 
       void LowPowerOn();
       void LowPowerOff();
@@ -34,6 +62,7 @@ namespace Pinetime {
       uint8_t pinDataCommand;
       uint8_t pinReset;
       uint8_t verticalScrollingStartAddress = 0;
+      PixelFormats pixelFormat = PixelFormats::Rgb565;
       bool sleepIn;
       TickType_t lastSleepExit;
 
@@ -47,7 +76,7 @@ namespace Pinetime {
       void MemoryDataAccessControl();
       void DisplayInversionOn();
       void NormalModeOn();
-      void WriteToRam(const uint8_t* data, size_t size);
+      void WriteToRam(const uint8_t* data, size_t size, SpiMaster::TransferDoneCallback transferDoneCallback, void* transferDoneContext);
       void IdleModeOn();
       void IdleModeOff();
       void FrameRateNormalSet();
@@ -60,10 +89,15 @@ namespace Pinetime {
       void PorchSet();
 
       void SetAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+      void InvalidateAddressWindow();
       void SetVdv();
       void WriteCommand(uint8_t cmd);
       void WriteCommand(const uint8_t* data, size_t size);
-      void WriteSpi(const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook);
+      void WriteSpi(const uint8_t* data,
+                    size_t size,
+                    bool isData,
+                    SpiMaster::TransferDoneCallback transferDoneCallback = nullptr,
+                    void* transferDoneContext = nullptr);
 
       enum class Commands : uint8_t {
         SoftwareReset = 0x01,
@@ -97,7 +131,13 @@ namespace Pinetime {
       static constexpr uint16_t Width = 240;
       static constexpr uint16_t Height = 320;
 
+      uint8_t addrColumnArgs[4];
       uint8_t addrWindowArgs[4];
+      static constexpr uint16_t invalidAddress = 0xffff;
+      uint16_t columnStart = invalidAddress;
+      uint16_t columnEnd = invalidAddress;
+      uint16_t rowStart = invalidAddress;
+      uint16_t rowEnd = invalidAddress;
       uint8_t verticalScrollArgs[2];
     };
   }
@@ -32,6 +32,7 @@
 #include "components/ble/BleController.h"
 #include "components/ble/NotificationManager.h"
 #include "components/brightness/BrightnessController.h"
+#include "components/display/FrameStatistics.h"
 #include "components/motor/MotorController.h"
 #include "components/datetime/DateTimeController.h"
 #include "components/heartrate/HeartRateController.h"
@@ -108,6 +109,7 @@ Pinetime::Controllers::AlarmController alarmController {dateTimeController, fs};
 Pinetime::Controllers::TouchHandler touchHandler;
 Pinetime::Controllers::ButtonHandler buttonHandler;
 Pinetime::Controllers::BrightnessController brightnessController {};
+Pinetime::Controllers::FrameStatistics frameStatistics;
 
 Pinetime::Applications::DisplayApp displayApp(lcd,
                                               touchPanel,
@@ -124,7 +126,8 @@ Pinetime::Applications::DisplayApp displayApp(lcd,
                                               brightnessController,
                                               touchHandler,
                                               fs,
-                                              spiNorFlash);
+                                              spiNorFlash,
+                                              frameStatistics);
 
 Pinetime::System::SystemTask systemTask(spi,
                                         spiNorFlash,
@@ -145,7 +148,8 @@ Pinetime::System::SystemTask systemTask(spi,
                                         heartRateApp,
                                         fs,
                                         touchHandler,
-                                        buttonHandler);
+                                        buttonHandler,
+                                        frameStatistics);
 int mallocFailedCount = 0;
 int stackOverflowCount = 0;
 extern "C" {
@@ -208,6 +212,15 @@ void SPIM0_SPIS0_TWIM0_TWIS0_SPI0_TWI0_IRQHandler(void) {
   }
 }
 
+extern "C" {
+void TIMER3_IRQHandler(void) {
+  if (NRF_TIMER3->EVENTS_COMPARE[1] == 1) {
+    NRF_TIMER3->EVENTS_COMPARE[1] = 0;
+    spi.OnListEndEvent();
+  }
+}
+}
+
 static void (*radio_isr_addr)();
 static void (*rng_isr_addr)();
 static void (*rtc0_isr_addr)();
@@ -273,6 +286,7 @@ void nimble_port_run(void) {
 }
 
 void BleHost(void* /*unused*/) {
+  fs.RegisterClient(Pinetime::Controllers::FS::Clients::Ble, xTaskGetCurrentTaskHandle());
   nimble_port_run();
 }
 
@@ -313,6 +327,10 @@ int main() {
   enable_dcdc_regulator();
   logger.Init();
 
+  // The cycle counter is off after reset, the drivers (SpiMaster, TwiMaster) and ElapsedTime read it
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
   nrf_drv_clock_init();
   nrf_drv_clock_lfclk_request(nullptr);
 
@@ -29,6 +29,8 @@ namespace Pinetime {
       BatteryPercentageUpdated,
       StartFileTransfer,
       StopFileTransfer,
+      FileTransferData,
+      OnFilesChanged,
       BleRadioEnableToggle
     };
   }
@@ -5,6 +5,7 @@
 #include "BootloaderVersion.h"
 #include "components/battery/BatteryController.h"
 #include "components/ble/BleController.h"
+#include "components/fs/FSBenchmark.h"
 #include "displayapp/TouchEvents.h"
 #include "drivers/Cst816s.h"
 #include "drivers/St7789.h"
@@ -51,7 +52,8 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
                        Pinetime::Applications::HeartRateTask& heartRateApp,
                        Pinetime::Controllers::FS& fs,
                        Pinetime::Controllers::TouchHandler& touchHandler,
-                       Pinetime::Controllers::ButtonHandler& buttonHandler)
+                       Pinetime::Controllers::ButtonHandler& buttonHandler,
+                       Pinetime::Controllers::FrameStatistics& frameStatistics)
   : spi {spi},
     spiNorFlash {spiNorFlash},
     twiMaster {twiMaster},
@@ -80,14 +82,17 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
                      spiNorFlash,
                      heartRateController,
                      motionController,
-                     fs) {
+                     fs,
+                     frameStatistics),
+    history {fs} {
 }
 
 void SystemTask::Start() {
   systemTasksMsgQueue = xQueueCreate(10, 1);
-  if (pdPASS != xTaskCreate(SystemTask::Process, "MAIN", 350, this, 1, &taskHandle)) {
+  if (pdPASS != xTaskCreate(SystemTask::Process, "MAIN", stackSize, this, 1, &taskHandle)) {
     APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
   }
+  fs.RegisterClient(Controllers::FS::Clients::System, taskHandle);
 }
 
 void SystemTask::Process(void* instance) {
@@ -111,6 +116,11 @@ void SystemTask::Work() {
   spiNorFlash.Wakeup();
 
   fs.Init();
+#ifdef FS_BENCHMARK
+  Controllers::FSBenchmark(fs).Run();
+  NRF_LOG_INFO("[FSBenchmark] MAIN stack: %lu of %d words never used", uxTaskGetStackHighWaterMark(nullptr), stackSize);
+#endif
+  history.Init();
 
   nimbleController.Init();
 
@@ -225,6 +235,7 @@ void SystemTask::Work() {
           break;
         case Messages::BleFirmwareUpdateStarted:
           GoToRunning();
+          history.Flush();
           wakeLocksHeld++;
           displayApp.PushMessage(Pinetime::Applications::Display::Messages::BleFirmwareUpdateStarted);
           break;
@@ -245,6 +256,12 @@ void SystemTask::Work() {
           wakeLocksHeld--;
           // TODO add intent of fs access icon or something
           break;
+        case Messages::FileTransferData:
+          nimbleController.fs().ProcessUpload();
+          break;
+        case Messages::OnFilesChanged:
+          displayApp.PushMessage(Pinetime::Applications::Display::Messages::FilesChanged);
+          break;
         case Messages::OnTouchEvent:
           // Finish immediately if no new events
           if (!touchHandler.ProcessTouchInfo(touchPanel.GetTouchInfo())) {
@@ -319,6 +336,10 @@ void SystemTask::Work() {
           // We might be sleeping (with TWI device disabled.
           // Remember we'll have to reset the counter next time we're awake
           stepCounterMustBeReset = true;
+          {
+            StorageAccess storage {*this};
+            history.Flush();
+          }
           break;
         case Messages::OnNewHour:
           using Pinetime::Controllers::AlarmController;
@@ -342,6 +363,7 @@ void SystemTask::Work() {
           break;
         case Messages::MeasureBatteryTimerExpired:
           batteryController.MeasureVoltage();
+          RecordHistory();
           break;
         case Messages::BatteryPercentageUpdated:
           nimbleController.NotifyBatteryLevel(batteryController.PercentRemaining());
@@ -373,6 +395,14 @@ void SystemTask::Work() {
       }
     }
 
+    // Erase free file system blocks ahead of time while nobody is waiting on the watch: when it starts going to sleep,
+    // or while it charges. Once asleep, the flash is in deep power-down and the SPI bus may be off.
+    const bool storageAwake =
+      (state == SystemTaskState::GoingToSleep) || (state == SystemTaskState::Running && batteryController.IsPowerPresent());
+    if (storageAwake && wakeLocksHeld == 0) {
+      fs.PreErase();
+    }
+
     monitor.Process();
     NoInit_BackUpTime = dateTimeController.CurrentDateTime();
     if (nrf_gpio_pin_read(PinMap::Button) == 0) {
@@ -382,6 +412,50 @@ void SystemTask::Work() {
 #pragma clang diagnostic pop
 }
 
+void SystemTask::RecordHistory() {
+  const auto now = std::chrono::duration_cast<std::chrono::seconds>(dateTimeController.UTCDateTime().time_since_epoch()).count();
+  // The time has not been set yet
+  if (now < minHistoryTime) {
+    return;
+  }
+
+  // Appending may flush the records to the file system
+  StorageAccess storage {*this};
+
+  // The step counter is reset every day
+  const uint32_t steps = motionController.NbSteps();
+  const uint32_t newSteps = (steps >= lastRecordedSteps) ? steps - lastRecordedSteps : steps;
+  lastRecordedSteps = steps;
+  history.Append(Controllers::TimeSeries::Metrics::Steps, now, newSteps);
+
+  if (heartRateController.State() == Controllers::HeartRateController::States::Running) {
+    history.Append(Controllers::TimeSeries::Metrics::HeartRate, now, heartRateController.HeartRate());
+  }
+  history.Append(Controllers::TimeSeries::Metrics::BatteryVoltage, now, batteryController.Voltage());
+}
+
+SystemTask::StorageAccess::StorageAccess(SystemTask& systemTask)
+  : systemTask {systemTask},
+    // The display still uses the SPI bus in AOD, it is only switched off in Sleeping
+    spiWasSleeping {systemTask.state == SystemTaskState::Sleeping},
+    flashWasSleeping {systemTask.spiNorFlash.IsSleeping()} {
+  if (spiWasSleeping) {
+    systemTask.spi.Wakeup();
+  }
+  if (flashWasSleeping) {
+    systemTask.spiNorFlash.Wakeup();
+  }
+}
+
+SystemTask::StorageAccess::~StorageAccess() {
+  if (flashWasSleeping) {
+    systemTask.spiNorFlash.Sleep();
+  }
+  if (spiWasSleeping) {
+    systemTask.spi.Sleep();
+  }
+}
+
 void SystemTask::GoToRunning() {
   if (state == SystemTaskState::Running) {
     return;
@@ -17,6 +17,7 @@
 #include "components/ble/NotificationManager.h"
 #include "components/alarm/AlarmController.h"
 #include "components/fs/FS.h"
+#include "components/fs/TimeSeries.h"
 #include "touchhandler/TouchHandler.h"
 #include "buttonhandler/ButtonHandler.h"
 #include "buttonhandler/ButtonActions.h"
@@ -72,7 +73,8 @@ namespace Pinetime {
                  Pinetime::Applications::HeartRateTask& heartRateApp,
                  Pinetime::Controllers::FS& fs,
                  Pinetime::Controllers::TouchHandler& touchHandler,
-                 Pinetime::Controllers::ButtonHandler& buttonHandler);
+                 Pinetime::Controllers::ButtonHandler& buttonHandler,
+                 Pinetime::Controllers::FrameStatistics& frameStatistics);
 
       void Start();
       void PushMessage(Messages msg);
@@ -116,6 +118,7 @@ namespace Pinetime {
       Pinetime::Controllers::TouchHandler& touchHandler;
       Pinetime::Controllers::ButtonHandler& buttonHandler;
       Pinetime::Controllers::NimbleController nimbleController;
+      Pinetime::Controllers::TimeSeries history;
 
       static void Process(void* instance);
       void Work();
@@ -132,8 +135,31 @@ namespace Pinetime {
       void GoToSleep();
       void UpdateMotion();
       bool stepCounterMustBeReset = false;
+      // In words. The history compaction (two files open, then a rename) and the uploads run littlefs writes and
+      // commits from this task: 350 words left no margin on the deepest path
+      static constexpr uint16_t stackSize = 500;
       static constexpr TickType_t batteryMeasurementPeriod = pdMS_TO_TICKS(10 * 60 * 1000);
 
+      // Wakes the SPI bus and the flash up for the file system while the watch sleeps, and puts them back to sleep
+      class StorageAccess {
+      public:
+        explicit StorageAccess(SystemTask& systemTask);
+        ~StorageAccess();
+        StorageAccess(const StorageAccess&) = delete;
+        StorageAccess& operator=(const StorageAccess&) = delete;
+
+      private:
+        SystemTask& systemTask;
+        bool spiWasSleeping;
+        bool flashWasSleeping;
+      };
+
+      // Steps, heart rate and battery voltage are recorded with each battery measurement
+      void RecordHistory();
+      uint32_t lastRecordedSteps = 0;
+      // 2022-01-01, earlier times mean the time has not been set
+      static constexpr int64_t minHistoryTime = 1640995200;
+
       SystemMonitor monitor;
     };
   }
@@ -31,6 +31,11 @@ namespace Pinetime {
         return *this;
       }
 
+      // The next IsUpdated() returns true even if the value does not change, to display it again
+      void Invalidate() {
+        this->isUpdated = true;
+      }
+
     private:
       T value {};            // NSDMI - default initialise type
       bool isUpdated {true}; // NSDMI - use brace initialisation
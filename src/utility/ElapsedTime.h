@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <nrf.h>
+
+namespace Pinetime {
+  namespace Utility {
+    // 64 MHz CPU clock
+    static constexpr uint32_t cpuCyclesPerMicrosecond = 64;
+
+    constexpr uint32_t CyclesToMicroseconds(uint32_t cycles) {
+      return cycles / cpuCyclesPerMicrosecond;
+    }
+
+    // Measures a duration in us, including the time the task spends blocked. The DWT cycle counter is precise but stops
+    // while the CPU sleeps (WFI, tickless idle), the tick count keeps running but only has a ~1 ms resolution: both give
+    // a lower bound of the elapsed time, the larger one is used.
+    class ElapsedTime {
+    public:
+      ElapsedTime() : startCycles {DWT->CYCCNT}, startTicks {xTaskGetTickCount()} {
+      }
+
+      uint32_t Microseconds() const {
+        const uint32_t fromCycles = CyclesToMicroseconds(DWT->CYCCNT - startCycles);
+        // The first tick may have begun just before the measurement started
+        const TickType_t ticks = xTaskGetTickCount() - startTicks;
+        const uint32_t fromTicks = (ticks > 1) ? static_cast<uint64_t>(ticks - 1) * 1000000 / configTICK_RATE_HZ : 0;
+        return std::max(fromCycles, fromTicks);
+      }
+
+    private:
+      uint32_t startCycles;
+      TickType_t startTicks;
+    };
+  }
+}
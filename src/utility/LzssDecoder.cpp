@@ -0,0 +1,82 @@
+#include "utility/LzssDecoder.h"
+
+using namespace Pinetime::Utility;
+
+void LzssDecoder::Init(uint8_t windowBits, uint32_t outputSize, uint8_t* window) {
+  this->window = window;
+  this->windowBits = windowBits;
+  this->outputSize = outputSize;
+  windowMask = (1 << windowBits) - 1;
+  head = 0;
+  pending = 0;
+  produced = 0;
+  state = States::Flags;
+  flags = 0;
+  nbItems = 0;
+  matchLow = 0;
+}
+
+bool LzssDecoder::Decode(const uint8_t* data, size_t size, Consumer consumer, void* context) {
+  for (size_t i = 0; i < size && !IsDone(); i++) {
+    const uint8_t byte = data[i];
+    switch (state) {
+      case States::Flags:
+        flags = byte;
+        nbItems = 8;
+        state = States::Item;
+        break;
+
+      case States::Item:
+        if ((flags & 0x01) != 0) {
+          Put(byte, consumer, context);
+          flags >>= 1;
+          state = (--nbItems == 0) ? States::Flags : States::Item;
+        } else {
+          matchLow = byte;
+          state = States::MatchHigh;
+        }
+        break;
+
+      case States::MatchHigh: {
+        const uint16_t token = matchLow | (byte << 8);
+        const uint32_t distance = (token & windowMask) + 1;
+        uint32_t length = (token >> windowBits) + minMatchLength;
+        if (distance > produced) {
+          return false;
+        }
+        if (length > outputSize - produced) {
+          length = outputSize - produced;
+        }
+        // Byte by byte: the match can overlap the data it produces
+        while (length-- > 0) {
+          Put(window[(head - distance) & windowMask], consumer, context);
+        }
+        flags >>= 1;
+        state = (--nbItems == 0) ? States::Flags : States::Item;
+        break;
+      }
+    }
+  }
+
+  Flush(consumer, context);
+  return true;
+}
+
+void LzssDecoder::Put(uint8_t byte, Consumer consumer, void* context) {
+  window[head] = byte;
+  head = (head + 1) & windowMask;
+  pending++;
+  produced++;
+  // The end of the window is reached, pass it to the consumer before it is overwritten
+  if (head == 0) {
+    Flush(consumer, context);
+  }
+}
+
+void LzssDecoder::Flush(Consumer consumer, void* context) {
+  if (pending > 0) {
+    // The pending bytes never wrap around the end of the window
+    consumer(context, window + ((head - pending) & windowMask), pending);
+    pending = 0;
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Utility {
+    // Streaming decoder for the LZSS format produced by tools/dfu_compress.py.
+    //
+    // The stream is a sequence of groups: a flag byte followed by up to 8 items, described by the bits of the flag
+    // byte starting with the least significant one. A set bit is a literal byte. A cleared bit is a match, encoded
+    // as a 16-bit little endian integer: the low windowBits bits are the distance minus 1, the other bits are the
+    // length minus minMatchLength. The stream ends once outputSize bytes have been produced.
+    //
+    // The input can be fed in pieces of any size. The output is passed to the consumer in pieces, at the latest
+    // at the end of each call to Decode(). The window buffer, provided by the caller, holds the last
+    // 2^windowBits bytes of output.
+    class LzssDecoder {
+    public:
+      static constexpr uint8_t minWindowBits = 8;
+      static constexpr uint8_t maxWindowBits = 12;
+      static constexpr uint8_t minMatchLength = 3;
+
+      using Consumer = void (*)(void* context, const uint8_t* data, size_t size);
+
+      void Init(uint8_t windowBits, uint32_t outputSize, uint8_t* window);
+      // Returns false if the data is corrupted: a match refers to data before the start of the output
+      bool Decode(const uint8_t* data, size_t size, Consumer consumer, void* context);
+
+      bool IsDone() const {
+        return produced == outputSize;
+      }
+
+      uint32_t Produced() const {
+        return produced;
+      }
+
+    private:
+      enum class States : uint8_t { Flags, Item, MatchHigh };
+
+      void Put(uint8_t byte, Consumer consumer, void* context);
+      void Flush(Consumer consumer, void* context);
+
+      uint8_t* window = nullptr;
+      uint8_t windowBits = 0;
+      uint16_t windowMask = 0;
+      uint16_t head = 0;
+      // Bytes of the window not passed to the consumer yet
+      uint16_t pending = 0;
+      uint32_t outputSize = 0;
+      uint32_t produced = 0;
+      States state = States::Flags;
+      uint8_t flags = 0;
+      uint8_t nbItems = 0;
+      uint8_t matchLow = 0;
+    };
+  }
+}
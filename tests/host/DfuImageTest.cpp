@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "components/ble/DfuImage.h"
+#include "drivers/SpiNorFlash.h"
+#include "HostTest.h"
+
+using Pinetime::Controllers::DfuImage;
+using Pinetime::Drivers::SpiNorFlash;
+
+namespace {
+  // OTA area of components/fs/FS.h, the magic number ends the 464 KB of the area
+  constexpr uint32_t imageAddress = 0x40000;
+  constexpr uint32_t magicAddress = imageAddress + 475136 - 16;
+  constexpr size_t packetSize = 20;
+
+  // Repeated sequences, like code, with some variation so that the image does not compress to nothing
+  std::vector<uint8_t> MakeImage(size_t size) {
+    std::vector<uint8_t> image(size);
+    uint32_t random = 1;
+    for (size_t i = 0; i < size; i++) {
+      random = random * 1103515245 + 12345;
+      image[i] = ((random >> 16) % 4 == 0) ? static_cast<uint8_t>(random >> 24) : static_cast<uint8_t>(i % 61);
+    }
+    return image;
+  }
+
+  // Same format as tools/dfu_compress.py, with an exhaustive search of the window
+  std::vector<uint8_t> Compress(const std::vector<uint8_t>& data, uint8_t windowBits) {
+    constexpr size_t minMatch = 3;
+    const size_t windowSize = 1u << windowBits;
+    const size_t maxMatch = (1u << (16 - windowBits)) - 1 + minMatch;
+    const uint32_t size = data.size();
+    std::vector<uint8_t> out = {'I', 'T', 'L', 'Z', 1, windowBits, 0, 0};
+    for (int i = 0; i < 4; i++) {
+      out.push_back(static_cast<uint8_t>(size >> (8 * i)));
+    }
+
+    size_t flagsIndex = 0;
+    size_t nbItems = 8;
+    for (size_t position = 0; position < data.size(); nbItems++) {
+      if (nbItems == 8) {
+        flagsIndex = out.size();
+        out.push_back(0);
+        nbItems = 0;
+      }
+      size_t bestLength = 0;
+      size_t bestDistance = 0;
+      for (size_t distance = 1; distance <= std::min(windowSize, position); distance++) {
+        size_t length = 0;
+        while (length < maxMatch && position + length < data.size() && data[position - distance + length] == data[position + length]) {
+          length++;
+        }
+        if (length > bestLength) {
+          bestLength = length;
+          bestDistance = distance;
+        }
+      }
+      if (bestLength >= minMatch) {
+        const uint16_t token = (bestDistance - 1) | ((bestLength - minMatch) << windowBits);
+        out.push_back(static_cast<uint8_t>(token));
+        out.push_back(static_cast<uint8_t>(token >> 8));
+        position += bestLength;
+      } else {
+        out[flagsIndex] |= 1 << nbItems;
+        out.push_back(data[position]);
+        position++;
+      }
+    }
+    return out;
+  }
+
+  uint16_t Crc(const std::vector<uint8_t>& data) {
+    return DfuImage::ComputeCrc(data.data(), data.size(), nullptr);
+  }
+
+  // Sends the data in packets like the DFU client, returns true if the image is complete
+  bool Send(DfuImage& image, const std::vector<uint8_t>& data, uint16_t crc) {
+    image.Init(packetSize, data.size(), crc);
+    image.Erase();
+    std::vector<uint8_t> packet(packetSize);
+    for (size_t offset = 0; offset < data.size(); offset += packetSize) {
+      const size_t size = std::min(packetSize, data.size() - offset);
+      std::memcpy(packet.data(), data.data() + offset, size);
+      image.Append(packet.data(), size);
+    }
+    return image.IsComplete();
+  }
+
+  bool Written(const SpiNorFlash& flash, const std::vector<uint8_t>& image) {
+    return std::memcmp(flash.Data() + imageAddress, image.data(), image.size()) == 0;
+  }
+
+  bool MagicNumberWritten(const SpiNorFlash& flash) {
+    const uint8_t magic[] = {0x77, 0xc2, 0x95, 0xf3, 0x60, 0xd2, 0xef, 0x7f, 0x35, 0x52, 0x50, 0x0f, 0x2c, 0xb6, 0x79, 0x80};
+    return std::memcmp(flash.Data() + magicAddress, magic, sizeof(magic)) == 0;
+  }
+
+  void ImagesAreWrittenAndValidated() {
+    SpiNorFlash flash;
+    DfuImage dfuImage {flash};
+    const auto image = MakeImage(30001);
+    CHECK(Send(dfuImage, image, Crc(image)));
+    CHECK(dfuImage.Validate());
+    CHECK(Written(flash, image));
+    CHECK(MagicNumberWritten(flash));
+    CHECK(flash.GetTotalCounters().bytesOverwritten == 0);
+    // Whole pages, except the last one, and the magic number
+    CHECK(flash.GetCounters(SpiNorFlash::Regions::Ota).pagePrograms == (image.size() + 255) / 256 + 1);
+  }
+
+  void CompressedImagesAreWrittenAndValidated() {
+    SpiNorFlash flash;
+    DfuImage dfuImage {flash};
+    const auto image = MakeImage(30001);
+    const auto compressed = Compress(image, 10);
+    CHECK(compressed.size() < image.size());
+    CHECK(Send(dfuImage, compressed, Crc(image)));
+    CHECK(dfuImage.Validate());
+    CHECK(Written(flash, image));
+    CHECK(MagicNumberWritten(flash));
+  }
+
+  void WrongCrcIsRejected() {
+    SpiNorFlash flash;
+    DfuImage dfuImage {flash};
+    const auto image = MakeImage(5000);
+    CHECK(Send(dfuImage, image, Crc(image) ^ 1));
+    CHECK(!dfuImage.Validate());
+  }
+
+  void FlashFailuresAreRejected() {
+    SpiNorFlash flash;
+    DfuImage dfuImage {flash};
+    const auto image = MakeImage(5000);
+    flash.SetFaulty(imageAddress + 2048, 1);
+    CHECK(Send(dfuImage, image, Crc(image)));
+    CHECK(!dfuImage.Validate());
+  }
+
+  void FailuresOfPreviousImagesAreIgnored() {
+    SpiNorFlash flash;
+    flash.SetFaulty(0x100000, 1);
+    flash.SectorErase(0x100000);
+    DfuImage dfuImage {flash};
+    const auto image = MakeImage(5000);
+    CHECK(Send(dfuImage, image, Crc(image)));
+    CHECK(dfuImage.Validate());
+  }
+
+  void CorruptedFlashIsRejected() {
+    SpiNorFlash flash;
+    DfuImage dfuImage {flash};
+    const auto image = MakeImage(5000);
+    CHECK(Send(dfuImage, image, Crc(image)));
+    // The flash reports no failure, but does not hold the data received
+    const uint8_t zero = 0;
+    flash.Write(imageAddress + 1000, &zero, 1);
+    CHECK(!dfuImage.Validate());
+  }
+
+  void MagicNumberIsWrittenOnce() {
+    SpiNorFlash flash;
+    DfuImage dfuImage {flash};
+    const auto image = MakeImage(5000);
+    CHECK(Send(dfuImage, image, Crc(image)));
+    const auto programs = flash.GetCounters(SpiNorFlash::Regions::Ota).pagePrograms;
+    // An empty packet after the end of the image
+    uint8_t data[1];
+    dfuImage.Append(data, 0);
+    CHECK(flash.GetCounters(SpiNorFlash::Regions::Ota).pagePrograms == programs);
+    CHECK(flash.GetEraseCount(magicAddress) == 1);
+    CHECK(dfuImage.Validate());
+  }
+}
+
+int main() {
+  ImagesAreWrittenAndValidated();
+  CompressedImagesAreWrittenAndValidated();
+  WrongCrcIsRejected();
+  FlashFailuresAreRejected();
+  FailuresOfPreviousImagesAreIgnored();
+  CorruptedFlashIsRejected();
+  MagicNumberIsWrittenOnce();
+  return HostTest::Result();
+}
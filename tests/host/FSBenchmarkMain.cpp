@@ -0,0 +1,36 @@
+#include <cstdio>
+#include <cstring>
+#include "components/fs/FS.h"
+#include "components/fs/FSBenchmark.h"
+#include "drivers/SpiNorFlash.h"
+
+// Runs the storage workloads of FSBenchmark on the emulated flash, then reports the flash traffic and the wear.
+//   fs-benchmark [--image <flash image>] [--wear <csv file>]
+// With an image, the file system starts from its content and is saved back to it, like the watch between reboots.
+// Fails when the workloads program bits that were not erased or use the flash while it sleeps.
+int main(int argc, char** argv) {
+  const char* imagePath = nullptr;
+  const char* wearPath = nullptr;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--image") == 0) {
+      imagePath = argv[i + 1];
+    } else if (std::strcmp(argv[i], "--wear") == 0) {
+      wearPath = argv[i + 1];
+    }
+  }
+
+  Pinetime::Drivers::SpiNorFlash flash {{}, imagePath};
+  flash.Init();
+  Pinetime::Controllers::FS fs {flash};
+  fs.Init();
+  Pinetime::Controllers::FSBenchmark(fs).Run();
+  fs.LogClientStatistics();
+  flash.LogReport();
+
+  if (wearPath != nullptr && !flash.SaveWear(wearPath)) {
+    std::printf("Cannot write %s\n", wearPath);
+    return 1;
+  }
+  const auto counters = flash.GetTotalCounters();
+  return (counters.bytesOverwritten == 0 && counters.commandsWhileSleeping == 0) ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+#include <cstdio>
+#include <vector>
+#include "components/fs/FS.h"
+#include "components/fs/FileReadCache.h"
+#include "drivers/SpiNorFlash.h"
+#include "SimulatedTime.h"
+
+// Replays the reads LVGL makes when it loads a font and an image from the file system, once straight through littlefs
+// (as before the cache) and once through FileReadCache, and reports the SPI transactions and the time of each load.
+//   file-read-cache-benchmark
+namespace {
+  using Pinetime::Controllers::FileReadCache;
+  using Pinetime::Controllers::FS;
+  using Pinetime::Drivers::SpiNorFlash;
+
+  constexpr const char* fontPath = "/benchmark-font.bin";
+  constexpr uint32_t fontSize = 12 * 1024;
+  constexpr uint32_t fontHeaderSize = 2048;
+  constexpr uint32_t nbGlyphs = 40;
+  constexpr uint32_t glyphSize = 60;
+
+  constexpr const char* imagePath = "/benchmark-image.bin";
+  constexpr uint32_t imageWidth = 240;
+  constexpr uint32_t imageHeight = 240;
+  constexpr uint32_t imageHeaderSize = 4;
+
+  // One read of a load: seek to position, then read size bytes
+  struct Access {
+    uint32_t position;
+    uint32_t size;
+  };
+
+  // lv_font_load() parses the tables of the header in small sequential reads, then each glyph drawn reads its bitmap
+  std::vector<Access> FontLoad() {
+    std::vector<Access> accesses;
+    uint32_t position = 0;
+    for (uint32_t i = 0; position < fontHeaderSize; i++) {
+      const uint32_t size = (i % 3 == 0) ? 4 : (i % 3 == 1) ? 2 : 16;
+      accesses.push_back({position, size});
+      position += size;
+    }
+    uint32_t random = 12345;
+    for (uint32_t i = 0; i < nbGlyphs; i++) {
+      random = random * 1103515245 + 12345;
+      const uint32_t glyph = (random >> 16) % ((fontSize - fontHeaderSize) / glyphSize);
+      accesses.push_back({fontHeaderSize + glyph * glyphSize, glyphSize});
+    }
+    return accesses;
+  }
+
+  // The LVGL file decoder reads the header, then the image one line at a time
+  std::vector<Access> ImageLoad() {
+    std::vector<Access> accesses;
+    accesses.push_back({0, imageHeaderSize});
+    for (uint32_t line = 0; line < imageHeight; line++) {
+      accesses.push_back({imageHeaderSize + line * imageWidth * 2, imageWidth * 2});
+    }
+    return accesses;
+  }
+
+  uint32_t ImageSize() {
+    return imageHeaderSize + imageWidth * imageHeight * 2;
+  }
+
+  void CreateFile(FS& fs, const char* path, uint32_t size) {
+    std::vector<uint8_t> data(size);
+    for (uint32_t i = 0; i < size; i++) {
+      data[i] = static_cast<uint8_t>(i * 7);
+    }
+    lfs_file_t file;
+    fs.FileOpen(&file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    fs.FileWrite(&file, data.data(), size);
+    fs.FileClose(&file);
+  }
+
+  struct Cost {
+    uint32_t transactions;
+    double milliseconds;
+  };
+
+  class Measure {
+  public:
+    explicit Measure(const SpiNorFlash& flash) : flash {flash}, transactions {Transactions()}, start {Pinetime::Host::Now()} {
+    }
+
+    Cost Result() const {
+      return {Transactions() - transactions, static_cast<double>(Pinetime::Host::Now() - start) / 1e6};
+    }
+
+  private:
+    uint32_t Transactions() const {
+      return flash.GetTotalCounters().transactions;
+    }
+
+    const SpiNorFlash& flash;
+    uint32_t transactions;
+    uint64_t start;
+  };
+
+  Cost LoadDirect(const SpiNorFlash& flash, FS& fs, const char* path, const std::vector<Access>& accesses) {
+    std::vector<uint8_t> buffer(imageWidth * 2);
+    const Measure measure {flash};
+    lfs_file_t file;
+    fs.FileOpen(&file, path, LFS_O_RDONLY);
+    for (const auto& access : accesses) {
+      fs.FileSeek(&file, access.position);
+      fs.FileRead(&file, buffer.data(), access.size);
+    }
+    fs.FileClose(&file);
+    return measure.Result();
+  }
+
+  Cost LoadCached(const SpiNorFlash& flash, FileReadCache& cache, const char* path, const std::vector<Access>& accesses) {
+    std::vector<uint8_t> buffer(imageWidth * 2);
+    const Measure measure {flash};
+    FileReadCache::File file;
+    cache.Open(file, path);
+    for (const auto& access : accesses) {
+      cache.Seek(file, access.position);
+      cache.Read(file, buffer.data(), access.size);
+    }
+    cache.Close(file);
+    return measure.Result();
+  }
+
+  void Report(const char* name, size_t nbAccesses, const Cost& direct, const Cost& cached) {
+    std::printf("[FileReadCache] %s, %u reads: %u SPI transactions in %.1f ms without the cache, %u in %.1f ms with it\n",
+                name,
+                static_cast<uint32_t>(nbAccesses),
+                direct.transactions,
+                direct.milliseconds,
+                cached.transactions,
+                cached.milliseconds);
+  }
+}
+
+int main() {
+  SpiNorFlash flash;
+  flash.Init();
+  FS fs {flash};
+  fs.Init();
+  CreateFile(fs, fontPath, fontSize);
+  CreateFile(fs, imagePath, ImageSize());
+
+  FileReadCache cache {fs};
+  const auto font = FontLoad();
+  const auto image = ImageLoad();
+  Report("font", font.size(), LoadDirect(flash, fs, fontPath, font), LoadCached(flash, cache, fontPath, font));
+  Report("image", image.size(), LoadDirect(flash, fs, imagePath, image), LoadCached(flash, cache, imagePath, image));
+
+  const auto& statistics = cache.GetStatistics();
+  std::printf("[FileReadCache] %u hits, %u misses, %u read-aheads, %u direct reads\n",
+              statistics.hits,
+              statistics.misses,
+              statistics.readAheads,
+              statistics.directReads);
+
+  fs.FileDelete(fontPath);
+  fs.FileDelete(imagePath);
+  return 0;
+}
@@ -0,0 +1,150 @@
+#include <cstdio>
+#include <cstring>
+#include <task.h>
+#include "drivers/SpiNorFlash.h"
+#include "SimulatedTime.h"
+#include "HostTest.h"
+
+using Pinetime::Drivers::SpiNorFlash;
+
+namespace {
+  constexpr uint32_t fileSystemAddress = 0x0B4000;
+
+  void ProgramsOnlyClearBits() {
+    SpiNorFlash flash;
+    const uint8_t first[] = {0xF0, 0x0F};
+    const uint8_t second[] = {0x3C, 0xFF};
+    flash.Write(fileSystemAddress, first, sizeof(first));
+    flash.Write(fileSystemAddress, second, sizeof(second));
+    uint8_t data[2];
+    flash.Read(fileSystemAddress, data, sizeof(data));
+    CHECK(data[0] == 0x30);
+    CHECK(data[1] == 0x0F);
+    CHECK(flash.GetCounters(SpiNorFlash::Regions::FileSystem).bytesOverwritten == 2);
+  }
+
+  void WritesAreSplitAtPageBoundaries() {
+    SpiNorFlash flash;
+    uint8_t data[4];
+    std::memset(data, 0x00, sizeof(data));
+    // A single page program would wrap around to the start of its page
+    flash.Write(fileSystemAddress + SpiNorFlash::pageSize - 2, data, 4);
+    uint8_t page[SpiNorFlash::pageSize + 2];
+    flash.Read(fileSystemAddress, page, sizeof(page));
+    CHECK(page[SpiNorFlash::pageSize - 2] == 0x00);
+    CHECK(page[SpiNorFlash::pageSize] == 0x00);
+    CHECK(page[0] == 0xFF);
+    CHECK(flash.GetCounters(SpiNorFlash::Regions::FileSystem).pagePrograms == 2);
+  }
+
+  void EraseSetsTheWholeSector() {
+    SpiNorFlash flash;
+    const uint8_t zero[SpiNorFlash::sectorSize] = {};
+    flash.Write(fileSystemAddress, zero, sizeof(zero));
+    flash.Write(fileSystemAddress + SpiNorFlash::sectorSize, zero, 1);
+    flash.SectorErase(fileSystemAddress + 100);
+    CHECK(flash.Data()[fileSystemAddress] == 0xFF);
+    CHECK(flash.Data()[fileSystemAddress + SpiNorFlash::sectorSize - 1] == 0xFF);
+    CHECK(flash.Data()[fileSystemAddress + SpiNorFlash::sectorSize] == 0x00);
+    CHECK(flash.GetEraseCount(fileSystemAddress) == 1);
+    CHECK(flash.GetCounters(SpiNorFlash::Regions::FileSystem).sectorErases == 1);
+    CHECK(flash.GetCounters(SpiNorFlash::Regions::Ota).sectorErases == 0);
+  }
+
+  void OperationsKeepTheFlashBusy() {
+    SpiNorFlash::Timings timings;
+    SpiNorFlash flash {timings};
+    uint64_t start = Pinetime::Host::Now();
+    flash.BeginSectorErase(fileSystemAddress);
+    // Started, not completed
+    CHECK(Pinetime::Host::Now() - start < timings.sectorEraseTime);
+    uint8_t data;
+    flash.Read(fileSystemAddress, &data, 1);
+    CHECK(Pinetime::Host::Now() - start >= timings.sectorEraseTime);
+    CHECK(flash.GetWriteStatistics().blockedTime >= (timings.sectorEraseTime / 1000) - 100);
+
+    start = Pinetime::Host::Now();
+    const uint8_t page[SpiNorFlash::pageSize] = {};
+    flash.Write(fileSystemAddress, page, sizeof(page));
+    flash.Write(fileSystemAddress + SpiNorFlash::pageSize, page, sizeof(page));
+    flash.WaitReady();
+    CHECK(Pinetime::Host::Now() - start >= 2 * static_cast<uint64_t>(timings.pageProgramTime));
+  }
+
+  void FaultyAreasFail() {
+    SpiNorFlash flash;
+    flash.SetFaulty(fileSystemAddress + SpiNorFlash::pageSize, 1);
+    const uint8_t zero[2 * SpiNorFlash::pageSize] = {};
+    flash.Write(fileSystemAddress, zero, sizeof(zero));
+    flash.WaitReady();
+    CHECK(flash.GetWriteStatistics().programFailures == 1);
+    CHECK(flash.Data()[fileSystemAddress] == 0x00);
+    CHECK(flash.Data()[fileSystemAddress + SpiNorFlash::pageSize] == 0xFF);
+
+    flash.SectorErase(fileSystemAddress);
+    CHECK(flash.GetWriteStatistics().eraseFailures == 1);
+    CHECK(flash.EraseFailed());
+    CHECK(flash.Data()[fileSystemAddress] == 0x00);
+  }
+
+  void ImageFilesKeepTheContent() {
+    const char* path = "flash-emulator-test.img";
+    const uint8_t data[] = {1, 2, 3};
+    {
+      SpiNorFlash flash {{}, path};
+      flash.Write(0x40000, data, sizeof(data));
+    }
+    SpiNorFlash flash {{}, path};
+    CHECK(std::memcmp(flash.Data() + 0x40000, data, sizeof(data)) == 0);
+    CHECK(flash.Data()[0x40000 + sizeof(data)] == 0xFF);
+    std::remove(path);
+  }
+
+  void SleepingFlashRefusesOperations() {
+    SpiNorFlash flash;
+    const uint8_t zero = 0;
+    flash.Sleep();
+    flash.Write(fileSystemAddress, &zero, 1);
+    flash.BeginSectorErase(fileSystemAddress);
+    uint8_t data = 0x55;
+    flash.Read(fileSystemAddress, &data, 1);
+    CHECK(data == 0x55);
+    CHECK(flash.Data()[fileSystemAddress] == 0xFF);
+    CHECK(flash.GetTotalCounters().commandsWhileSleeping == 3);
+    CHECK(flash.GetCounters(SpiNorFlash::Regions::FileSystem).sectorErases == 0);
+
+    flash.Wakeup();
+    flash.Write(fileSystemAddress, &zero, 1);
+    CHECK(flash.Data()[fileSystemAddress] == 0x00);
+  }
+
+  void StreamsAreReadInSessions() {
+    SpiNorFlash flash;
+    uint8_t buffer[256];
+    uint32_t received = 0;
+    flash.ReadStream(
+      fileSystemAddress,
+      10000,
+      buffer,
+      sizeof(buffer),
+      [](void* context, const uint8_t*, size_t size) {
+        *static_cast<uint32_t*>(context) += size;
+      },
+      &received);
+    CHECK(received == 10000);
+    // 4 KB per session
+    CHECK(flash.GetCounters(SpiNorFlash::Regions::FileSystem).reads == 3);
+  }
+}
+
+int main() {
+  ProgramsOnlyClearBits();
+  WritesAreSplitAtPageBoundaries();
+  EraseSetsTheWholeSector();
+  OperationsKeepTheFlashBusy();
+  FaultyAreasFail();
+  ImageFilesKeepTheContent();
+  SleepingFlashRefusesOperations();
+  StreamsAreReadInSessions();
+  return HostTest::Result();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdio>
+
+// Checks of the host tests: a failed check is reported and the test carries on, main() returns HostTest::Result()
+namespace HostTest {
+  inline int failures = 0;
+
+  inline void Check(bool condition, const char* expression, const char* file, int line) {
+    if (!condition) {
+      std::printf("%s:%d: check failed: %s\n", file, line, expression);
+      failures++;
+    }
+  }
+
+  inline int Result() {
+    if (failures > 0) {
+      std::printf("%d checks failed\n", failures);
+      return 1;
+    }
+    return 0;
+  }
+}
+
+#define CHECK(condition) HostTest::Check((condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,149 @@
+#include <cstdio>
+#include "components/settings/Settings.h"
+#include "components/fs/FS.h"
+#include "HostTest.h"
+
+using Pinetime::Controllers::FS;
+using Pinetime::Controllers::Settings;
+
+namespace {
+  constexpr const char* settingsPath = "/settings.dat";
+  // Records kept before the journal is folded into the snapshot (Settings::maxJournalRecords)
+  constexpr uint32_t maxJournalRecords = 16;
+
+  struct Values {
+    uint32_t stepsGoal;
+    Settings::ClockType clockType;
+
+    bool operator==(const Values&) const = default;
+  };
+
+  Values Load(FS& fs) {
+    Settings settings {fs};
+    settings.Init();
+    return {settings.GetStepsGoal(), settings.GetClockType()};
+  }
+
+  void Save(Settings& settings, const Values& values) {
+    settings.SetStepsGoal(values.stepsGoal);
+    settings.SetClockType(values.clockType);
+    settings.SaveSettings();
+  }
+
+  void ChangesAreReplayed() {
+    FS fs;
+    Settings settings {fs};
+    settings.Init();
+    Save(settings, {1000, Settings::ClockType::H24});
+    const uint32_t snapshotOperations = fs.Operations();
+    Save(settings, {2000, Settings::ClockType::H24});
+    Save(settings, {2000, Settings::ClockType::H12});
+    // One attribute each
+    CHECK(fs.Operations() == snapshotOperations + 2);
+    CHECK(fs.AttributeCount(settingsPath) == 2);
+    CHECK((Load(fs) == Values {2000, Settings::ClockType::H12}));
+  }
+
+  // Bytes written by a save: a whole snapshot, the size of every save before the journal, or a journal record
+  uint32_t BytesWrittenBy(FS& fs, Settings& settings, const Values& values) {
+    const uint32_t start = fs.BytesWritten();
+    Save(settings, values);
+    return fs.BytesWritten() - start;
+  }
+
+  void ReportLoadCost(FS& fs, const char* description) {
+    const uint32_t reads = fs.Reads();
+    const uint32_t bytesRead = fs.BytesRead();
+    Load(fs);
+    std::printf("Load with %s: %u reads, %u B read\n", description, fs.Reads() - reads, fs.BytesRead() - bytesRead);
+  }
+
+  // The sizes are the payloads of the file system operations: littlefs adds a metadata commit to each of them (tags and
+  // CRC, programmed in units of its prog_size), and copies the data blocks of a file rewritten
+  void ReportWriteAndLoadCost() {
+    FS fs;
+    Settings settings {fs};
+    settings.Init();
+    const uint32_t snapshotBytes = BytesWrittenBy(fs, settings, {1000, Settings::ClockType::H24});
+    ReportLoadCost(fs, "no journal record");
+    const uint32_t stepsGoalBytes = BytesWrittenBy(fs, settings, {2000, Settings::ClockType::H24});
+    const uint32_t clockTypeBytes = BytesWrittenBy(fs, settings, {2000, Settings::ClockType::H12});
+    std::printf("Snapshot: %u B, change of the steps goal: %u B, change of the clock type: %u B\n",
+                snapshotBytes,
+                stepsGoalBytes,
+                clockTypeBytes);
+    CHECK(stepsGoalBytes > 0 && stepsGoalBytes < snapshotBytes / 4);
+    CHECK(clockTypeBytes > 0 && clockTypeBytes < snapshotBytes / 4);
+
+    for (uint32_t i = 2; i < maxJournalRecords; i++) {
+      Save(settings, {2000 + i, Settings::ClockType::H12});
+    }
+    ReportLoadCost(fs, "a full journal");
+  }
+
+  void InterruptedRecordsAreIgnored() {
+    FS fs;
+    Settings settings {fs};
+    settings.Init();
+    Save(settings, {1000, Settings::ClockType::H24});
+    Save(settings, {2000, Settings::ClockType::H24});
+    fs.PowerLossAfter(0);
+    Save(settings, {3000, Settings::ClockType::H12});
+    fs.PowerOn();
+    CHECK((Load(fs) == Values {2000, Settings::ClockType::H24}));
+  }
+
+  void FullJournalsAreFolded() {
+    FS fs;
+    Settings settings {fs};
+    settings.Init();
+    for (uint32_t i = 0; i <= maxJournalRecords; i++) {
+      Save(settings, {1000 + i, Settings::ClockType::H24});
+    }
+    CHECK(fs.AttributeCount(settingsPath) == maxJournalRecords);
+    Save(settings, {5000, Settings::ClockType::H12});
+    CHECK(fs.AttributeCount(settingsPath) == 0);
+    CHECK((Load(fs) == Values {5000, Settings::ClockType::H12}));
+
+    // The journal starts again after the new snapshot
+    Save(settings, {6000, Settings::ClockType::H12});
+    CHECK(fs.AttributeCount(settingsPath) == 1);
+    CHECK((Load(fs) == Values {6000, Settings::ClockType::H12}));
+  }
+
+  // A power loss at any point of the folding gives the settings before or after the save, never a mix of both. This relies
+  // on the atomic operations of memoryfs, which models littlefs: it does not exercise littlefs itself
+  void InterruptedFoldsKeepConsistentSettings() {
+    const Values before {1000 + maxJournalRecords, Settings::ClockType::H24};
+    const Values after {5000, Settings::ClockType::H12};
+    for (uint32_t operations = 0;; operations++) {
+      FS fs;
+      Settings settings {fs};
+      settings.Init();
+      for (uint32_t i = 0; i <= maxJournalRecords; i++) {
+        Save(settings, {1000 + i, Settings::ClockType::H24});
+      }
+      const uint32_t start = fs.Operations();
+      fs.PowerLossAfter(operations);
+      Save(settings, after);
+      const bool completed = fs.Operations() - start < operations;
+      fs.PowerOn();
+
+      const Values loaded = Load(fs);
+      CHECK(loaded == before || loaded == after);
+      if (completed) {
+        CHECK(loaded == after);
+        break;
+      }
+    }
+  }
+}
+
+int main() {
+  ChangesAreReplayed();
+  ReportWriteAndLoadCost();
+  InterruptedRecordsAreIgnored();
+  FullJournalsAreFolded();
+  InterruptedFoldsKeepConsistentSettings();
+  return HostTest::Result();
+}
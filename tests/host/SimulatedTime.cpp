@@ -0,0 +1,13 @@
+#include "SimulatedTime.h"
+
+namespace {
+  uint64_t now = 0;
+}
+
+uint64_t Pinetime::Host::Now() {
+  return now;
+}
+
+void Pinetime::Host::Advance(uint64_t nanoseconds) {
+  now += nanoseconds;
+}
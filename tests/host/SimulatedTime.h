@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Host {
+    // Time of the simulated watch, in ns since the start of the program. Nothing runs concurrently on the host: the time
+    // only advances when a stand-in of the hardware or of FreeRTOS says so (flash latencies, SPI transfers, vTaskDelay).
+    uint64_t Now();
+    void Advance(uint64_t nanoseconds);
+  }
+}
@@ -0,0 +1,350 @@
+#include "drivers/SpiNorFlash.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "SimulatedTime.h"
+
+using namespace Pinetime::Drivers;
+
+namespace {
+  // Flash map of components/fs/FS.h
+  constexpr uint32_t otaStart = 0x040000;
+  constexpr uint32_t fileSystemStart = 0x0B4000;
+}
+
+SpiNorFlash::SpiNorFlash() : SpiNorFlash(Timings {}) {
+}
+
+SpiNorFlash::SpiNorFlash(const Timings& timings, const char* imagePath)
+  : timings {timings},
+    memory(flashSize, 0xFF),
+    eraseCounts(flashSize / sectorSize),
+    faultyPages(flashSize / pageSize),
+    startTime {Host::Now()} {
+  if (imagePath == nullptr) {
+    return;
+  }
+  this->imagePath = imagePath;
+  std::ifstream image(imagePath, std::ios::binary);
+  image.read(reinterpret_cast<char*>(memory.data()), memory.size());
+}
+
+SpiNorFlash::~SpiNorFlash() {
+  if (imagePath.empty()) {
+    return;
+  }
+  std::ofstream image(imagePath, std::ios::binary | std::ios::trunc);
+  image.write(reinterpret_cast<const char*>(memory.data()), memory.size());
+}
+
+void SpiNorFlash::Init() {
+  // XTX XT25F32B
+  device_id = {0x0B, 0x40, 0x16};
+}
+
+void SpiNorFlash::Uninit() {
+}
+
+void SpiNorFlash::Sleep() {
+  WaitReady();
+  Transaction(1);
+  sleeping = true;
+}
+
+void SpiNorFlash::Wakeup() {
+  sleeping = false;
+  Transaction(5);
+}
+
+void SpiNorFlash::Transaction(size_t size) {
+  if (sleeping) {
+    commandsWhileSleeping++;
+  }
+  transactions++;
+  Host::Advance(timings.transactionTime + static_cast<uint64_t>(size) * timings.byteTime);
+}
+
+uint8_t SpiNorFlash::ReadStatusRegister() {
+  Transaction(2);
+  return ((Host::Now() < busyUntil) ? 0x01 : 0x00) | (writeEnabled ? 0x02 : 0x00);
+}
+
+bool SpiNorFlash::WriteInProgress() {
+  return (ReadStatusRegister() & 0x01u) == 0x01u;
+}
+
+bool SpiNorFlash::WriteEnabled() {
+  return (ReadStatusRegister() & 0x02u) == 0x02u;
+}
+
+uint8_t SpiNorFlash::ReadConfigurationRegister() {
+  Transaction(2);
+  return 0;
+}
+
+bool SpiNorFlash::RefuseWhileSleeping() {
+  if (sleeping) {
+    commandsWhileSleeping++;
+  }
+  return sleeping;
+}
+
+void SpiNorFlash::Read(uint32_t address, uint8_t* buffer, size_t size) {
+  if (RefuseWhileSleeping()) {
+    return;
+  }
+  WaitReady();
+  Transaction(fastReadCmdSize + size);
+  for (size_t i = 0; i < size; i++) {
+    // The address wraps around at the end of the flash
+    buffer[i] = memory[(address + i) % flashSize];
+  }
+  auto& regionCounters = CountersOf(address);
+  regionCounters.reads++;
+  regionCounters.bytesRead += size;
+}
+
+void SpiNorFlash::ReadStream(
+  uint32_t address, size_t size, uint8_t* buffer, size_t bufferSize, ReadStreamConsumer consumer, void* context) {
+  while (size > 0) {
+    const size_t sessionSize = std::min(size, streamSessionSize);
+    if (RefuseWhileSleeping()) {
+      return;
+    }
+    WaitReady();
+    Transaction(fastReadCmdSize);
+    for (size_t done = 0; done < sessionSize;) {
+      const size_t chunkSize = std::min(bufferSize, sessionSize - done);
+      for (size_t i = 0; i < chunkSize; i++) {
+        buffer[i] = memory[(address + done + i) % flashSize];
+      }
+      Host::Advance(static_cast<uint64_t>(chunkSize) * timings.byteTime);
+      consumer(context, buffer, chunkSize);
+      done += chunkSize;
+    }
+    auto& regionCounters = CountersOf(address);
+    regionCounters.reads++;
+    regionCounters.bytesRead += sessionSize;
+
+    address += sessionSize;
+    size -= sessionSize;
+  }
+}
+
+void SpiNorFlash::WriteEnable() {
+  Transaction(1);
+  writeEnabled = true;
+}
+
+void SpiNorFlash::SectorErase(uint32_t sectorAddress) {
+  BeginSectorErase(sectorAddress);
+  WaitReady();
+}
+
+void SpiNorFlash::BeginSectorErase(uint32_t sectorAddress) {
+  StartOperation(Operations::SectorErase, sectorAddress, nullptr, 0);
+  writeStatistics.sectorsErased++;
+}
+
+void SpiNorFlash::StartOperation(Operations operation, uint32_t address, const uint8_t* data, size_t size) {
+  if (RefuseWhileSleeping()) {
+    return;
+  }
+  WaitReady();
+  WriteEnable();
+  while (!WriteEnabled()) {
+  }
+  Transaction(4 + size);
+  writeEnabled = false;
+
+  auto& regionCounters = CountersOf(address);
+  if (operation == Operations::SectorErase) {
+    const uint32_t sector = address - (address % sectorSize);
+    regionCounters.sectorErases++;
+    eraseCounts[sector / sectorSize]++;
+    if (IsFaulty(sector, sectorSize)) {
+      securityRegister = eraseFailedFlag;
+    } else {
+      std::fill_n(memory.begin() + sector, sectorSize, 0xFF);
+      securityRegister = 0;
+    }
+    busyUntil = Host::Now() + timings.sectorEraseTime;
+  } else {
+    const uint32_t page = address - (address % pageSize);
+    regionCounters.pagePrograms++;
+    regionCounters.bytesProgrammed += size;
+    if (IsFaulty(page, pageSize)) {
+      securityRegister = programFailedFlag;
+    } else {
+      for (size_t i = 0; i < size; i++) {
+        // The address wraps around at the end of the page
+        uint8_t& byte = memory[page + ((address + i) % pageSize)];
+        if ((data[i] & ~byte) != 0) {
+          regionCounters.bytesOverwritten++;
+        }
+        byte &= data[i];
+      }
+      securityRegister = 0;
+    }
+    busyUntil = Host::Now() + timings.pageProgramTime;
+  }
+  pendingOperation = operation;
+}
+
+void SpiNorFlash::WaitReady() {
+  if (pendingOperation == Operations::None) {
+    return;
+  }
+
+  const uint64_t now = Host::Now();
+  if (now < busyUntil) {
+    writeStatistics.blockedTime += (busyUntil - now) / 1000;
+    Host::Advance(busyUntil - now);
+  }
+  // Last status poll
+  Transaction(2);
+  const Operations completed = pendingOperation;
+  pendingOperation = Operations::None;
+
+  const uint8_t flags = ReadSecurityRegister();
+  if (completed == Operations::PageProgram && (flags & programFailedFlag) != 0) {
+    writeStatistics.programFailures++;
+  } else if (completed == Operations::SectorErase && (flags & eraseFailedFlag) != 0) {
+    writeStatistics.eraseFailures++;
+  }
+}
+
+uint8_t SpiNorFlash::ReadSecurityRegister() {
+  WaitReady();
+  Transaction(2);
+  return securityRegister;
+}
+
+bool SpiNorFlash::ProgramFailed() {
+  return (ReadSecurityRegister() & programFailedFlag) == programFailedFlag;
+}
+
+bool SpiNorFlash::EraseFailed() {
+  return (ReadSecurityRegister() & eraseFailedFlag) == eraseFailedFlag;
+}
+
+void SpiNorFlash::Write(uint32_t address, const uint8_t* buffer, size_t size) {
+  while (size > 0) {
+    const uint32_t pageLimit = address - (address % pageSize) + pageSize;
+    const size_t toWrite = std::min<size_t>(pageLimit - address, size);
+    StartOperation(Operations::PageProgram, address, buffer, toWrite);
+    writeStatistics.bytesProgrammed += toWrite;
+
+    address += toWrite;
+    buffer += toWrite;
+    size -= toWrite;
+  }
+}
+
+SpiNorFlash::Identification SpiNorFlash::GetIdentification() const {
+  return device_id;
+}
+
+SpiNorFlash::Regions SpiNorFlash::RegionOf(uint32_t address) {
+  if (address < otaStart) {
+    return Regions::BootloaderAssets;
+  }
+  if (address < fileSystemStart) {
+    return Regions::Ota;
+  }
+  return Regions::FileSystem;
+}
+
+const char* SpiNorFlash::RegionToString(Regions region) {
+  switch (region) {
+    case Regions::BootloaderAssets:
+      return "Bootloader assets";
+    case Regions::Ota:
+      return "OTA";
+    default:
+      return "File system";
+  }
+}
+
+SpiNorFlash::Counters SpiNorFlash::GetTotalCounters() const {
+  Counters total;
+  for (const auto& regionCounters : counters) {
+    total.reads += regionCounters.reads;
+    total.bytesRead += regionCounters.bytesRead;
+    total.pagePrograms += regionCounters.pagePrograms;
+    total.bytesProgrammed += regionCounters.bytesProgrammed;
+    total.sectorErases += regionCounters.sectorErases;
+    total.bytesOverwritten += regionCounters.bytesOverwritten;
+  }
+  total.transactions = transactions;
+  total.commandsWhileSleeping = commandsWhileSleeping;
+  return total;
+}
+
+void SpiNorFlash::SetFaulty(uint32_t address, size_t size) {
+  if (size == 0) {
+    return;
+  }
+  for (uint32_t page = address / pageSize; page <= (address + size - 1) / pageSize; page++) {
+    faultyPages[page] = true;
+  }
+}
+
+bool SpiNorFlash::IsFaulty(uint32_t address, size_t size) const {
+  for (uint32_t page = address / pageSize; page <= (address + size - 1) / pageSize; page++) {
+    if (faultyPages[page]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SpiNorFlash::LogReport() const {
+  const Counters total = GetTotalCounters();
+  std::printf("[Flash emulator] %.1f ms simulated, %u SPI transactions, %u ms waiting for programs and erases\n",
+              static_cast<double>(Host::Now() - startTime) / 1e6,
+              total.transactions,
+              writeStatistics.blockedTime / 1000);
+  for (size_t i = 0; i < nbRegions; i++) {
+    const auto region = static_cast<Regions>(i);
+    const auto& regionCounters = counters[i];
+    const uint32_t start = (region == Regions::BootloaderAssets) ? 0 : (region == Regions::Ota) ? otaStart : fileSystemStart;
+    const uint32_t end = (region == Regions::BootloaderAssets) ? otaStart : (region == Regions::Ota) ? fileSystemStart : flashSize;
+    uint32_t erasedSectors = 0;
+    uint16_t maxErases = 0;
+    for (uint32_t sector = start / sectorSize; sector < end / sectorSize; sector++) {
+      erasedSectors += (eraseCounts[sector] > 0) ? 1 : 0;
+      maxErases = std::max(maxErases, eraseCounts[sector]);
+    }
+    std::printf("[Flash emulator] %s: %u reads (%u B), %u page programs (%u B), %u sector erases\n",
+                RegionToString(region),
+                regionCounters.reads,
+                regionCounters.bytesRead,
+                regionCounters.pagePrograms,
+                regionCounters.bytesProgrammed,
+                regionCounters.sectorErases);
+    std::printf("[Flash emulator]   wear: %u of %u sectors erased, at most %u times\n",
+                erasedSectors,
+                static_cast<uint32_t>((end - start) / sectorSize),
+                maxErases);
+  }
+  if (total.bytesOverwritten > 0 || total.commandsWhileSleeping > 0) {
+    std::printf("[Flash emulator] %u bytes programmed over data that was not erased, %u commands sent while sleeping\n",
+                total.bytesOverwritten,
+                total.commandsWhileSleeping);
+  }
+}
+
+bool SpiNorFlash::SaveWear(const char* path) const {
+  FILE* file = std::fopen(path, "w");
+  if (file == nullptr) {
+    return false;
+  }
+  std::fprintf(file, "address,region,erases\n");
+  for (uint32_t sector = 0; sector < flashSize / sectorSize; sector++) {
+    const uint32_t address = sector * sectorSize;
+    std::fprintf(file, "0x%06x,%s,%u\n", address, RegionToString(RegionOf(address)), eraseCounts[sector]);
+  }
+  return std::fclose(file) == 0;
+}
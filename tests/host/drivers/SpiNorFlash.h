@@ -0,0 +1,169 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <FreeRTOS.h>
+
+namespace Pinetime {
+  namespace Drivers {
+    // Host stand-in for the SPI NOR flash driver (src/drivers/SpiNorFlash.h), with the same interface. The 4 MB flash is
+    // kept in RAM and optionally loaded from and saved to an image file, so that the content survives a "reboot".
+    // It behaves like the flash of the PineTime:
+    //  - a page program only clears bits, and wraps around at the end of its 256 B page
+    //  - a sector erase sets its 4 KB to 0xFF
+    //  - programs and erases keep the flash busy for a configurable time, the next operation waits for them
+    //  - programs and erases of the areas set with SetFaulty() fail, and set the flags of the security register
+    //  - like the driver, reads, programs and erases are refused between Sleep() and Wakeup()
+    // Every SPI transaction advances the simulated time (SimulatedTime.h).
+    class SpiNorFlash {
+    public:
+      // Latencies in ns, the defaults are the typical values of the datasheet and of the 8 MHz SPI bus
+      struct Timings {
+        uint32_t transactionTime = 5000; // chip select, DMA setup and SPI mutex, for each transaction
+        uint32_t byteTime = 1000;
+        uint32_t pageProgramTime = 600000;
+        uint32_t sectorEraseTime = 50000000;
+      };
+
+      SpiNorFlash();
+      explicit SpiNorFlash(const Timings& timings, const char* imagePath = nullptr);
+      ~SpiNorFlash();
+      SpiNorFlash(const SpiNorFlash&) = delete;
+      SpiNorFlash& operator=(const SpiNorFlash&) = delete;
+      SpiNorFlash(SpiNorFlash&&) = delete;
+      SpiNorFlash& operator=(SpiNorFlash&&) = delete;
+
+      using ReadStreamConsumer = void (*)(void* context, const uint8_t* data, size_t size);
+
+      struct WriteStatistics {
+        uint32_t bytesProgrammed = 0;
+        uint32_t sectorsErased = 0;
+        uint32_t blockedTime = 0; // us spent by the callers waiting for a program or an erase to complete
+        uint32_t programFailures = 0;
+        uint32_t eraseFailures = 0;
+      };
+
+      struct __attribute__((packed)) Identification {
+        uint8_t manufacturer = 0;
+        uint8_t type = 0;
+        uint8_t density = 0;
+      };
+
+      uint8_t ReadStatusRegister();
+      bool WriteInProgress();
+      bool WriteEnabled();
+      uint8_t ReadConfigurationRegister();
+      void Read(uint32_t address, uint8_t* buffer, size_t size);
+      void ReadStream(uint32_t address, size_t size, uint8_t* buffer, size_t bufferSize, ReadStreamConsumer consumer, void* context);
+      void Write(uint32_t address, const uint8_t* buffer, size_t size);
+      void WriteEnable();
+      void SectorErase(uint32_t sectorAddress);
+      void BeginSectorErase(uint32_t sectorAddress);
+      void WaitReady();
+      uint8_t ReadSecurityRegister();
+      bool ProgramFailed();
+      bool EraseFailed();
+
+      Identification GetIdentification() const;
+
+      const WriteStatistics& GetWriteStatistics() const {
+        return writeStatistics;
+      }
+
+      void Init();
+      void Uninit();
+
+      void Sleep();
+      void Wakeup();
+
+      bool IsSleeping() const {
+        return sleeping;
+      }
+
+      // Emulator only
+
+      static constexpr size_t flashSize = 0x400000;
+      static constexpr size_t pageSize = 256;
+      static constexpr size_t sectorSize = 4096;
+
+      // Areas of the flash map described in components/fs/FS.h
+      enum class Regions : uint8_t { BootloaderAssets, Ota, FileSystem };
+      static constexpr size_t nbRegions = 3;
+
+      // Only the region counters are kept per region, the SPI transactions and the commands sent while sleeping are totals
+      struct Counters {
+        uint32_t transactions = 0;
+        uint32_t reads = 0;
+        uint32_t bytesRead = 0;
+        uint32_t pagePrograms = 0;
+        uint32_t bytesProgrammed = 0;
+        uint32_t sectorErases = 0;
+        // Bytes programmed over bits that were not erased: the flash cannot set them, the data is corrupted
+        uint32_t bytesOverwritten = 0;
+        // Operations requested while the flash is in deep power-down, the driver refuses them
+        uint32_t commandsWhileSleeping = 0;
+      };
+
+      static Regions RegionOf(uint32_t address);
+      static const char* RegionToString(Regions region);
+
+      const Counters& GetCounters(Regions region) const {
+        return counters[static_cast<uint8_t>(region)];
+      }
+
+      Counters GetTotalCounters() const;
+
+      // Erases of the sector containing the address
+      uint16_t GetEraseCount(uint32_t address) const {
+        return eraseCounts[address / sectorSize];
+      }
+
+      // Programs and erases touching this area fail from now on
+      void SetFaulty(uint32_t address, size_t size);
+
+      const uint8_t* Data() const {
+        return memory.data();
+      }
+
+      // Simulated time, flash traffic and wear of each region
+      void LogReport() const;
+      // One line per sector: address, region and erase count
+      bool SaveWear(const char* path) const;
+
+    private:
+      enum class Operations : uint8_t { None, PageProgram, SectorErase };
+      static constexpr uint8_t programFailedFlag = 0x20;
+      static constexpr uint8_t eraseFailedFlag = 0x40;
+      static constexpr uint8_t fastReadCmdSize = 5;
+      static constexpr size_t streamSessionSize = 4096;
+
+      void Transaction(size_t size);
+      void StartOperation(Operations operation, uint32_t address, const uint8_t* data, size_t size);
+      bool RefuseWhileSleeping();
+      bool IsFaulty(uint32_t address, size_t size) const;
+      Counters& CountersOf(uint32_t address) {
+        return counters[static_cast<uint8_t>(RegionOf(address))];
+      }
+
+      Timings timings;
+      std::string imagePath;
+      std::vector<uint8_t> memory;
+      std::vector<uint16_t> eraseCounts;
+      std::vector<bool> faultyPages;
+      std::array<Counters, nbRegions> counters {};
+      uint32_t transactions = 0;
+      uint32_t commandsWhileSleeping = 0;
+      uint64_t startTime = 0;
+
+      Operations pendingOperation = Operations::None;
+      uint64_t busyUntil = 0;
+      bool writeEnabled = false;
+      bool sleeping = false;
+      uint8_t securityRegister = 0;
+      WriteStatistics writeStatistics;
+      Identification device_id;
+    };
+  }
+}
@@ -0,0 +1,165 @@
+#include "components/fs/FS.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace Pinetime::Controllers;
+
+int FS::FileOpen(lfs_file_t* file_p, const char* fileName, const int flags) {
+  auto entry = files.find(fileName);
+  if (entry == files.end() && (flags & LFS_O_CREAT) == 0) {
+    return LFS_ERR_NOENT;
+  }
+  file_p->path = fileName;
+  file_p->flags = flags;
+  file_p->position = 0;
+  file_p->data.clear();
+  if (entry != files.end() && (flags & LFS_O_TRUNC) == 0) {
+    file_p->data = entry->second.data;
+  }
+  if ((flags & LFS_O_APPEND) != 0) {
+    file_p->position = file_p->data.size();
+  }
+  return LFS_ERR_OK;
+}
+
+int FS::FileClose(lfs_file_t* file_p) {
+  // Like littlefs, the content written becomes visible when the file is closed
+  if ((file_p->flags & LFS_O_WRONLY) != 0) {
+    if (!Apply()) {
+      return LFS_ERR_IO;
+    }
+    files[file_p->path].data = file_p->data;
+    bytesWritten += file_p->data.size();
+  }
+  file_p->flags = 0;
+  return LFS_ERR_OK;
+}
+
+int FS::FileRead(lfs_file_t* file_p, uint8_t* buff, uint32_t size) {
+  if ((file_p->flags & LFS_O_RDONLY) == 0) {
+    return LFS_ERR_BADF;
+  }
+  const uint32_t length = std::min<uint32_t>(size, file_p->data.size() - std::min<size_t>(file_p->position, file_p->data.size()));
+  std::memcpy(buff, file_p->data.data() + file_p->position, length);
+  file_p->position += length;
+  reads++;
+  bytesRead += length;
+  return length;
+}
+
+int FS::FileWrite(lfs_file_t* file_p, const uint8_t* buff, uint32_t size) {
+  if ((file_p->flags & LFS_O_WRONLY) == 0) {
+    return LFS_ERR_BADF;
+  }
+  if (file_p->data.size() < file_p->position + size) {
+    file_p->data.resize(file_p->position + size);
+  }
+  std::memcpy(file_p->data.data() + file_p->position, buff, size);
+  file_p->position += size;
+  return size;
+}
+
+int FS::FileSeek(lfs_file_t* file_p, uint32_t pos) {
+  file_p->position = pos;
+  return pos;
+}
+
+int FS::FileSize(lfs_file_t* file_p) {
+  return file_p->data.size();
+}
+
+int FS::FileDelete(const char* fileName) {
+  if (files.count(fileName) == 0) {
+    return LFS_ERR_NOENT;
+  }
+  if (!Apply()) {
+    return LFS_ERR_IO;
+  }
+  files.erase(fileName);
+  return LFS_ERR_OK;
+}
+
+int FS::Rename(const char* oldPath, const char* newPath) {
+  auto entry = files.find(oldPath);
+  if (entry == files.end()) {
+    return LFS_ERR_NOENT;
+  }
+  if (!Apply()) {
+    return LFS_ERR_IO;
+  }
+  // The file replaced goes away with its attributes
+  Entry moved = std::move(entry->second);
+  files.erase(entry);
+  files[newPath] = std::move(moved);
+  return LFS_ERR_OK;
+}
+
+int FS::GetAttribute(const char* path, uint8_t type, void* buffer, uint32_t size) {
+  auto entry = files.find(path);
+  if (entry == files.end()) {
+    return LFS_ERR_NOENT;
+  }
+  reads++;
+  auto attribute = entry->second.attributes.find(type);
+  if (attribute == entry->second.attributes.end()) {
+    return LFS_ERR_NOATTR;
+  }
+  const uint32_t length = std::min<uint32_t>(size, attribute->second.size());
+  std::memcpy(buffer, attribute->second.data(), length);
+  bytesRead += length;
+  return attribute->second.size();
+}
+
+int FS::SetAttribute(const char* path, uint8_t type, const void* buffer, uint32_t size) {
+  auto entry = files.find(path);
+  if (entry == files.end()) {
+    return LFS_ERR_NOENT;
+  }
+  if (size > maxAttributeSize) {
+    return LFS_ERR_INVAL;
+  }
+  if (!Apply()) {
+    return LFS_ERR_IO;
+  }
+  const auto* bytes = static_cast<const uint8_t*>(buffer);
+  entry->second.attributes[type].assign(bytes, bytes + size);
+  bytesWritten += size;
+  return LFS_ERR_OK;
+}
+
+int FS::RemoveAttribute(const char* path, uint8_t type) {
+  auto entry = files.find(path);
+  if (entry == files.end()) {
+    return LFS_ERR_NOENT;
+  }
+  if (!Apply()) {
+    return LFS_ERR_IO;
+  }
+  entry->second.attributes.erase(type);
+  return LFS_ERR_OK;
+}
+
+void FS::PowerLossAfter(uint32_t operations) {
+  powerLossPending = true;
+  remainingOperations = operations;
+}
+
+void FS::PowerOn() {
+  powerLossPending = false;
+}
+
+size_t FS::AttributeCount(const char* path) const {
+  auto entry = files.find(path);
+  return (entry == files.end()) ? 0 : entry->second.attributes.size();
+}
+
+bool FS::Apply() {
+  if (powerLossPending) {
+    if (remainingOperations == 0) {
+      return false;
+    }
+    remainingOperations--;
+  }
+  operations++;
+  return true;
+}
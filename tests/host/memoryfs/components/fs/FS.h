@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Subset of littlefs used by the clients of the file system
+enum { LFS_ERR_OK = 0, LFS_ERR_IO = -5, LFS_ERR_NOENT = -2, LFS_ERR_BADF = -9, LFS_ERR_INVAL = -22, LFS_ERR_NOATTR = -61 };
+enum { LFS_O_RDONLY = 1, LFS_O_WRONLY = 2, LFS_O_RDWR = 3, LFS_O_CREAT = 0x0100, LFS_O_TRUNC = 0x0400, LFS_O_APPEND = 0x0800 };
+
+struct lfs_file_t {
+  std::string path;
+  std::vector<uint8_t> data;
+  uint32_t position = 0;
+  int flags = 0;
+};
+
+namespace Pinetime {
+  namespace Controllers {
+    // Host stand-in for the file system controller (src/components/fs/FS.h), for the clients that only need files and
+    // attributes. Files are kept in memory with the guarantees of littlefs: each operation (closing a file that was
+    // written, setting or removing an attribute, a rename) is applied completely or not at all. PowerLossAfter()
+    // simulates a power loss in the middle of a sequence of operations: the following ones are not applied.
+    class FS {
+    public:
+      FS() = default;
+      FS(const FS&) = delete;
+      FS& operator=(const FS&) = delete;
+      FS(FS&&) = delete;
+      FS& operator=(FS&&) = delete;
+
+      void Init() {
+      }
+
+      int FileOpen(lfs_file_t* file_p, const char* fileName, const int flags);
+      int FileClose(lfs_file_t* file_p);
+      int FileRead(lfs_file_t* file_p, uint8_t* buff, uint32_t size);
+      int FileWrite(lfs_file_t* file_p, const uint8_t* buff, uint32_t size);
+      int FileSeek(lfs_file_t* file_p, uint32_t pos);
+      int FileSize(lfs_file_t* file_p);
+      int FileDelete(const char* fileName);
+
+      int Rename(const char* oldPath, const char* newPath);
+      int GetAttribute(const char* path, uint8_t type, void* buffer, uint32_t size);
+      int SetAttribute(const char* path, uint8_t type, const void* buffer, uint32_t size);
+      int RemoveAttribute(const char* path, uint8_t type);
+      static constexpr size_t maxAttributeSize = 50;
+
+      // Emulator only
+
+      // The next operations are applied, the ones after them fail without changing anything
+      void PowerLossAfter(uint32_t operations);
+      // Applies the operations again, as after a reboot
+      void PowerOn();
+
+      // Operations applied since the file system was created
+      uint32_t Operations() const {
+        return operations;
+      }
+
+      // Content of the files closed after writing and of the attributes set, without the metadata littlefs adds
+      uint32_t BytesWritten() const {
+        return bytesWritten;
+      }
+
+      // File and attribute reads, and the bytes they returned
+      uint32_t Reads() const {
+        return reads;
+      }
+
+      uint32_t BytesRead() const {
+        return bytesRead;
+      }
+
+      bool Exists(const char* path) const {
+        return files.count(path) > 0;
+      }
+
+      size_t AttributeCount(const char* path) const;
+
+    private:
+      struct Entry {
+        std::vector<uint8_t> data;
+        std::map<uint8_t, std::vector<uint8_t>> attributes;
+      };
+
+      // Returns false when the power is lost, the operation must not be applied
+      bool Apply();
+
+      std::map<std::string, Entry> files;
+      uint32_t operations = 0;
+      uint32_t bytesWritten = 0;
+      uint32_t reads = 0;
+      uint32_t bytesRead = 0;
+      bool powerLossPending = false;
+      uint32_t remainingOperations = 0;
+    };
+  }
+}
@@ -0,0 +1,107 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+#include <cstdio>
+#include <cstdlib>
+#include "SimulatedTime.h"
+
+struct tskTaskControlBlock {
+  UBaseType_t priority = 1;
+  char name[5] = "host";
+};
+
+struct HostSemaphore {
+  enum class Types { Mutex, RecursiveMutex, Binary };
+  Types type;
+  UBaseType_t count;
+};
+
+namespace {
+  constexpr uint64_t nanosecondsPerTick = 1000000000ULL / configTICK_RATE_HZ;
+  tskTaskControlBlock hostTask;
+
+  SemaphoreHandle_t Create(HostSemaphore::Types type, UBaseType_t count) {
+    return new HostSemaphore {type, count};
+  }
+
+  BaseType_t Take(SemaphoreHandle_t semaphore, TickType_t timeout) {
+    const bool available =
+      (semaphore->type == HostSemaphore::Types::Mutex || semaphore->type == HostSemaphore::Types::Binary) ? semaphore->count == 0 : true;
+    if (available) {
+      semaphore->count++;
+      return pdTRUE;
+    }
+    if (timeout == portMAX_DELAY) {
+      // The only task would wait forever for itself
+      std::fprintf(stderr, "Deadlock: the task takes a semaphore it already holds\n");
+      std::abort();
+    }
+    vTaskDelay(timeout);
+    return pdFALSE;
+  }
+
+  BaseType_t Give(SemaphoreHandle_t semaphore) {
+    if (semaphore->count == 0) {
+      return pdFALSE;
+    }
+    semaphore->count--;
+    return pdTRUE;
+  }
+}
+
+size_t xPortGetFreeHeapSize() {
+  return configTOTAL_HEAP_SIZE;
+}
+
+TickType_t xTaskGetTickCount() {
+  return static_cast<TickType_t>(Pinetime::Host::Now() / nanosecondsPerTick);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  Pinetime::Host::Advance(ticks * nanosecondsPerTick);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return &hostTask;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+  return (task == nullptr) ? hostTask.priority : task->priority;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {
+  ((task == nullptr) ? hostTask : *task).priority = priority;
+}
+
+char* pcTaskGetName(TaskHandle_t task) {
+  return (task == nullptr) ? hostTask.name : task->name;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return Create(HostSemaphore::Types::Mutex, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+  return Create(HostSemaphore::Types::RecursiveMutex, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  // Created empty, like FreeRTOS does: the first take waits for a give
+  return Create(HostSemaphore::Types::Binary, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout) {
+  return Take(semaphore, timeout);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  return Give(semaphore);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t timeout) {
+  return Take(semaphore, timeout);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore) {
+  return Give(semaphore);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// Stand-in for the FreeRTOS API used by the storage code. There is a single task, the tick count follows the simulated
+// time (SimulatedTime.h), and the semaphores never block: taking a mutex that is already held is reported as a deadlock.
+
+#include <cstddef>
+#include <cstdint>
+
+using TickType_t = uint32_t;
+using BaseType_t = long;
+using UBaseType_t = unsigned long;
+
+#define configTICK_RATE_HZ      1024
+#define configMAX_PRIORITIES    3
+#define configTOTAL_HEAP_SIZE   (1024 * 40)
+
+#define pdFALSE       ((BaseType_t) 0)
+#define pdTRUE        ((BaseType_t) 1)
+#define pdPASS        (pdTRUE)
+#define pdFAIL        (pdFALSE)
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
+
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t) (((TickType_t) (xTimeInMs) * (TickType_t) configTICK_RATE_HZ) / (TickType_t) 1000U))
+
+size_t xPortGetFreeHeapSize();
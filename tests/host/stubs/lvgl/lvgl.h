@@ -0,0 +1,3 @@
+#pragma once
+
+// Included by components/fs/FS.cpp, which does not use LVGL
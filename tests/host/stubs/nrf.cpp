@@ -0,0 +1,9 @@
+#include <nrf.h>
+#include "SimulatedTime.h"
+
+HostDwt hostDwt;
+
+HostDwt::CycleCounter::operator uint32_t() const {
+  // 64 MHz CPU clock
+  return static_cast<uint32_t>((Pinetime::Host::Now() * 64) / 1000);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Stand-in for the DWT cycle counter of the nRF52 (64 MHz), derived from the simulated time
+
+#include <cstdint>
+
+struct HostDwt {
+  struct CycleCounter {
+    operator uint32_t() const;
+  };
+
+  CycleCounter CYCCNT;
+};
+
+extern HostDwt hostDwt;
+#define DWT (&hostDwt)
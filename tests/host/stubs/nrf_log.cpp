@@ -0,0 +1,38 @@
+#include <nrf_log.h>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+void HostLog(const char* format, ...) {
+  // uint32_t is an unsigned long on the nRF52, the firmware prints it with %lu: it is an unsigned int on the host
+  std::string hostFormat;
+  for (const char* c = format; *c != '\0'; c++) {
+    hostFormat += *c;
+    if (*c != '%') {
+      continue;
+    }
+    c++;
+    if (*c == '%') {
+      hostFormat += *c;
+      continue;
+    }
+    while (*c != '\0' && std::strchr("-+ #0123456789.*", *c) != nullptr) {
+      hostFormat += *c;
+      c++;
+    }
+    if (c[0] == 'l' && c[1] != 'l') {
+      c++;
+    }
+    if (*c == '\0') {
+      break;
+    }
+    hostFormat += *c;
+  }
+  hostFormat += '\n';
+
+  va_list args;
+  va_start(args, format);
+  std::vprintf(hostFormat.c_str(), args);
+  va_end(args);
+}
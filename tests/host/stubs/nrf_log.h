@@ -0,0 +1,23 @@
+#pragma once
+
+// Stand-in for the nRF logger, also included by littlefs (C). The messages are printed on stdout.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void HostLog(const char* format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Blocks, like the nRF macros: the firmware does not always end them with a semicolon
+#define NRF_LOG_INFO(...)                                                                                                                  \
+  { HostLog(__VA_ARGS__); }
+#define NRF_LOG_WARNING(...)                                                                                                               \
+  { HostLog(__VA_ARGS__); }
+#define NRF_LOG_ERROR(...)                                                                                                                 \
+  { HostLog(__VA_ARGS__); }
+#define NRF_LOG_DEBUG(...)                                                                                                                 \
+  {}
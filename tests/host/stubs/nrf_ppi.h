@@ -0,0 +1,8 @@
+#pragma once
+
+// Host stand-in for the PPI HAL of the nRF5 SDK: only the channel type is used by the headers built on the host
+typedef enum {
+  NRF_PPI_CHANNEL0 = 0,
+  NRF_PPI_CHANNEL1 = 1,
+  NRF_PPI_CHANNEL2 = 2,
+} nrf_ppi_channel_t;
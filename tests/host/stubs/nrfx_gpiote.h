@@ -0,0 +1,3 @@
+#pragma once
+
+// Host stand-in for the GPIOTE driver of the nRF5 SDK, nothing of it is used on the host
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+struct HostSemaphore;
+using SemaphoreHandle_t = HostSemaphore*;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t timeout);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+struct tskTaskControlBlock;
+using TaskHandle_t = tskTaskControlBlock*;
+
+TickType_t xTaskGetTickCount();
+// Advances the simulated time, there is no other task to run meanwhile
+void vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
+char* pcTaskGetName(TaskHandle_t task);
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskYIELD()
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+
+# Compresses the firmware image of a DFU package for DfuService (see doc/ble.md).
+#
+# The image is replaced by an LZSS stream preceded by a 12 bytes header; the init
+# packet (.dat) is kept as is, as the CRC it contains is checked against the
+# decompressed image. The package can be sent with any legacy DFU client, but only
+# to a watch running a firmware that supports compressed images.
+#
+# Header, little endian:
+#   'I' 'T' 'L' 'Z', version (1), window bits (8 to 12), 2 bytes reserved,
+#   size of the decompressed image (4 bytes)
+#
+# Example: ./dfu_compress.py pinetime-mcuboot-app-dfu-1.15.0.zip pinetime-mcuboot-app-dfu-compressed-1.15.0.zip
+
+import argparse
+import json
+import struct
+import sys
+import zipfile
+
+MAGIC = b"ITLZ"
+VERSION = 1
+MIN_MATCH = 3
+MAX_CHAIN = 256
+
+
+def compress(data, window_bits):
+    window_size = 1 << window_bits
+    max_match = (1 << (16 - window_bits)) - 1 + MIN_MATCH
+    out = bytearray()
+    # Positions of the previous occurrences of each 3 bytes prefix, most recent last
+    chains = {}
+    flags_index = 0
+    nb_items = 8
+    position = 0
+
+    def insert(index):
+        if index + MIN_MATCH <= len(data):
+            chains.setdefault(data[index:index + MIN_MATCH], []).append(index)
+
+    while position < len(data):
+        if nb_items == 8:
+            flags_index = len(out)
+            out.append(0)
+            nb_items = 0
+
+        best_length = 0
+        best_distance = 0
+        candidates = chains.get(data[position:position + MIN_MATCH], [])
+        limit = min(max_match, len(data) - position)
+        for candidate in reversed(candidates[-MAX_CHAIN:]):
+            distance = position - candidate
+            if distance > window_size:
+                break
+            length = 0
+            while length < limit and data[candidate + length] == data[position + length]:
+                length += 1
+            if length > best_length:
+                best_length = length
+                best_distance = distance
+                if length == limit:
+                    break
+
+        if best_length >= MIN_MATCH:
+            token = (best_distance - 1) | ((best_length - MIN_MATCH) << window_bits)
+            out += struct.pack("<H", token)
+            for index in range(position, position + best_length):
+                insert(index)
+            position += best_length
+        else:
+            out[flags_index] |= 1 << nb_items
+            out.append(data[position])
+            insert(position)
+            position += 1
+        nb_items += 1
+
+    return struct.pack("<4sBBHI", MAGIC, VERSION, window_bits, 0, len(data)) + bytes(out)
+
+
+def decompress(payload):
+    magic, version, window_bits, _, size = struct.unpack_from("<4sBBHI", payload)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a compressed image")
+    out = bytearray()
+    position = 12
+    while len(out) < size:
+        flags = payload[position]
+        position += 1
+        for _ in range(8):
+            if len(out) >= size:
+                break
+            if flags & 1:
+                out.append(payload[position])
+                position += 1
+            else:
+                token, = struct.unpack_from("<H", payload, position)
+                position += 2
+                distance = (token & ((1 << window_bits) - 1)) + 1
+                length = (token >> window_bits) + MIN_MATCH
+                for _ in range(min(length, size - len(out))):
+                    out.append(out[-distance])
+            flags >>= 1
+    return bytes(out)
+
+
+def transfer_time(size, throughput):
+    return size / throughput
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compress the firmware image of a DFU package")
+    parser.add_argument("input", help="DFU package (.zip) or firmware image (.bin)")
+    parser.add_argument("output", help="compressed DFU package or image")
+    parser.add_argument("--window-bits", type=int, default=12, choices=range(8, 13),
+                        help="log2 of the window size, the watch allocates a buffer of this size during DFU")
+    parser.add_argument("--throughput", type=float, default=[2.5, 8.0], nargs="+",
+                        help="DFU throughputs in KB/s used to estimate the transfer times")
+    args = parser.parse_args()
+
+    if args.input.endswith(".zip"):
+        with zipfile.ZipFile(args.input) as package:
+            manifest = json.loads(package.read("manifest.json"))
+            image_name = manifest["manifest"]["application"]["bin_file"]
+            image = package.read(image_name)
+            payload = compress(image, args.window_bits)
+            with zipfile.ZipFile(args.output, "w", zipfile.ZIP_DEFLATED) as output:
+                for item in package.infolist():
+                    output.writestr(item, payload if item.filename == image_name else package.read(item))
+    else:
+        with open(args.input, "rb") as f:
+            image = f.read()
+        payload = compress(image, args.window_bits)
+        with open(args.output, "wb") as f:
+            f.write(payload)
+
+    if decompress(payload) != image:
+        raise RuntimeError("the compressed image does not decompress to the original image")
+
+    print(f"image: {len(image)} bytes, compressed: {len(payload)} bytes ({100 * len(payload) / len(image):.1f}%)")
+    if len(payload) >= len(image):
+        print("warning: the compressed image is not smaller than the original one", file=sys.stderr)
+    for throughput in args.throughput:
+        before = transfer_time(len(image), throughput * 1024)
+        after = transfer_time(len(payload), throughput * 1024)
+        print(f"at {throughput} KB/s: {before:.0f} s -> {after:.0f} s")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+
+# Measures how fast a file can be read from the watch with the BLE FS service
+# (see doc/BLEFS.md), using one READ_PACING per chunk or a streaming read.
+#
+# A test file of the given size is uploaded first (one WRITE_PACING per chunk or
+# a streaming write), read back, compared and deleted.
+# Requires bleak (pip install bleak).
+#
+# Example: ./fs_read_benchmark.py --address C7:4A:64:D1:21:5F --size 102400 --mode stream
+
+import argparse
+import asyncio
+import os
+import struct
+import sys
+import time
+
+from bleak import BleakClient
+
+TRANSFER_UUID = "adaf0200-4669-6c65-5472-616e73666572"
+
+READ = 0x10
+READ_DATA = 0x11
+READ_PACING = 0x12
+READ_STREAM = 0x13
+READ_CREDIT = 0x14
+WRITE = 0x20
+WRITE_PACING = 0x21
+WRITE_DATA = 0x22
+WRITE_STREAM = 0x23
+DELETE = 0x30
+DELETE_STATUS = 0x31
+
+READ_DATA_HEADER = struct.Struct("<BbHIII")
+WRITE_PACING_FORMAT = struct.Struct("<BbHIQI")
+
+
+class FsClient:
+    def __init__(self, client):
+        self.client = client
+        self.responses = asyncio.Queue()
+
+    async def start(self):
+        await self.client.start_notify(TRANSFER_UUID, self.on_notification)
+
+    def on_notification(self, _, data):
+        self.responses.put_nowait(bytes(data))
+
+    async def send(self, data):
+        await self.client.write_gatt_char(TRANSFER_UUID, data, response=True)
+
+    async def response(self, command):
+        while True:
+            data = await asyncio.wait_for(self.responses.get(), timeout=10)
+            if data[0] == command:
+                return data
+
+    def payload_size(self, header_size):
+        return self.client.mtu_size - 3 - header_size
+
+    async def write(self, path, content):
+        path = path.encode()
+        await self.send(struct.pack("<BBHIQI", WRITE, 0, len(path), 0, 0, len(content)) + path)
+        _, status, _, _, _, _ = WRITE_PACING_FORMAT.unpack(await self.response(WRITE_PACING))
+        if status != 1:
+            raise RuntimeError(f"write failed: {status}")
+        chunk_size = self.payload_size(12)
+        for offset in range(0, len(content), chunk_size):
+            chunk = content[offset:offset + chunk_size]
+            await self.send(struct.pack("<BBHII", WRITE_DATA, 1, 0, offset, len(chunk)) + chunk)
+            _, status, _, _, _, _ = WRITE_PACING_FORMAT.unpack(await self.response(WRITE_PACING))
+            if status < 0:
+                raise RuntimeError(f"write failed: {status}")
+
+    async def write_stream(self, path, content):
+        path = path.encode()
+        await self.send(struct.pack("<BBHIQI", WRITE_STREAM, 0, len(path), 0, 0, len(content)) + path)
+        _, status, window, acked, _, _ = WRITE_PACING_FORMAT.unpack(await self.response(WRITE_PACING))
+        if status != 1:
+            raise RuntimeError(f"write failed: {status}")
+        chunk_size = self.payload_size(12)
+        offset = 0
+        while acked < len(content):
+            # Send without response as long as the data fits in the window, then wait for an acknowledgement
+            while offset < len(content) and offset + chunk_size <= acked + window:
+                chunk = content[offset:offset + chunk_size]
+                await self.client.write_gatt_char(TRANSFER_UUID, struct.pack("<BBHII", WRITE_DATA, 1, 0, offset, len(chunk)) + chunk, response=False)
+                offset += len(chunk)
+            _, status, _, acked, _, _ = WRITE_PACING_FORMAT.unpack(await self.response(WRITE_PACING))
+            if status < 0:
+                raise RuntimeError(f"write failed: {status}")
+
+    async def delete(self, path):
+        path = path.encode()
+        await self.send(struct.pack("<BBH", DELETE, 0, len(path)) + path)
+        await self.response(DELETE_STATUS)
+
+    def read_chunk(self, data, content):
+        _, status, _, offset, total, length = READ_DATA_HEADER.unpack_from(data)
+        if status < 0:
+            raise RuntimeError(f"read failed: {status}")
+        content[offset:offset + length] = data[READ_DATA_HEADER.size:READ_DATA_HEADER.size + length]
+        return offset + length, total
+
+    async def read_paced(self, path):
+        path = path.encode()
+        chunk_size = self.payload_size(READ_DATA_HEADER.size)
+        content = bytearray()
+        await self.send(struct.pack("<BBHII", READ, 0, len(path), 0, chunk_size) + path)
+        end, total = self.read_chunk(await self.response(READ_DATA), content)
+        while end < total:
+            await self.send(struct.pack("<BBHII", READ_PACING, 1, 0, end, chunk_size))
+            end, total = self.read_chunk(await self.response(READ_DATA), content)
+        return bytes(content)
+
+    async def read_stream(self, path, window):
+        path = path.encode()
+        content = bytearray()
+        received = 0
+        await self.send(struct.pack("<BBHII", READ_STREAM, 0, len(path), 0, window) + path)
+        credited = window
+        while True:
+            end, total = self.read_chunk(await self.response(READ_DATA), content)
+            received = max(received, end)
+            if received >= total:
+                return bytes(content)
+            # Grant more credit once half of the window has been received
+            if credited - received <= window // 2:
+                await self.send(struct.pack("<BBHII", READ_CREDIT, 0, 0, received, window))
+                credited = received + window
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="Measure the read throughput of the BLE FS service")
+    parser.add_argument("--address", required=True, help="Bluetooth address of the watch")
+    parser.add_argument("--size", type=int, default=100 * 1024, help="size of the test file in bytes")
+    parser.add_argument("--path", default="/fs_read_benchmark.bin", help="path of the test file on the watch")
+    parser.add_argument("--mode", choices=["paced", "stream", "both"], default="both")
+    parser.add_argument("--upload", choices=["paced", "stream"], default="stream", help="how the test file is uploaded")
+    parser.add_argument("--window", type=int, default=4096, help="credit granted to the watch in streaming mode, in bytes")
+    args = parser.parse_args()
+
+    content = os.urandom(args.size)
+    async with BleakClient(args.address) as client:
+        fs = FsClient(client)
+        await fs.start()
+        print(f"MTU: {client.mtu_size}")
+
+        start = time.monotonic()
+        if args.upload == "paced":
+            await fs.write(args.path, content)
+        else:
+            await fs.write_stream(args.path, content)
+        print(f"upload ({args.upload}): {args.size / 1024 / (time.monotonic() - start):.1f} KB/s")
+
+        modes = ["paced", "stream"] if args.mode == "both" else [args.mode]
+        for mode in modes:
+            start = time.monotonic()
+            if mode == "paced":
+                data = await fs.read_paced(args.path)
+            else:
+                data = await fs.read_stream(args.path, args.window)
+            duration = time.monotonic() - start
+            status = "ok" if data == content else "MISMATCH"
+            print(f"read ({mode}): {args.size / 1024 / duration:.1f} KB/s, {status}")
+
+        await fs.delete(args.path)
+
+
+if __name__ == "__main__":
+    sys.exit(asyncio.run(main()))